@@ -1,9 +1,13 @@
 require 'fileutils'
+require 'json'
 
 require_relative '../../../z80-libraries/vars'
 
 BENCHMARKS = File.join(__dir__, "src")
 
+# Every result is also appended here as a line of JSON.
+RESULTS_FILE = "benchmark_results.jsonl"
+
 class KernelBenchmark
     def start_instance(binary)
         binary_name = File.basename(binary, ".bin")
@@ -92,11 +96,16 @@ class KernelBenchmark
             if /^benchmark_/ =~ m
                 compile_test_code([File.join(BENCHMARKS, "#{m}.c")], "#{m}.bin")
 
+                @unit = "cycles"
                 @instance = start_instance("#{m}.bin")
                 avg, min, max = send(m)
                 @instance.quit
 
                 table[m] = [avg, min, max]
+
+                File.open(RESULTS_FILE, "a") do |f|
+                    f.puts({ benchmark: m, unit: @unit, avg: avg, min: min, max: max }.to_json)
+                end
             end
         end
 
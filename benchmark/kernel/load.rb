@@ -0,0 +1,58 @@
+require_relative 'base'
+
+class LoadBenchmarks < KernelBenchmark
+    # Cycles taken by process_load for the same 4KB image,
+    # stored as-is, compressed, and re-launched from the image cache.
+    def bench_load(skip = 0)
+        # Get symbols.
+        kernel_symbols = Zemu::Debug.load_map("kernel_debug.map")
+
+        load_start = kernel_symbols.find_by_name("_process_load").address
+
+        # We expect to start executing at 0x8000,
+        # where the command-processor would reside normally.
+        @instance.break 0x8000, :program
+        
+        # Run, and expect to hit the breakpoint.
+        @instance.continue
+        @instance.remove_break 0x8000, :program
+
+        @instance.break load_start, :program
+
+        # Skip loads that are not being measured.
+        skip.times do
+            @instance.continue 100000000
+        end
+
+        bench(5) do
+            @instance.continue 100000000
+
+            # Run until process_load returns to its caller.
+            sp = @instance.registers["SP"]
+            ret = @instance.memory(sp) | (@instance.memory(sp + 1) << 8)
+
+            @instance.break ret, :program
+            load_cycles = @instance.continue 100000000
+            @instance.remove_break ret, :program
+
+            load_cycles
+        end
+    end
+
+    def benchmark_load_exe
+        bench_load
+    end
+
+    def benchmark_load_lz
+        bench_load
+    end
+
+    def benchmark_load_cached
+        bench_load 1
+    end
+end
+
+def benchmarks
+    b = LoadBenchmarks.new
+    b.benchmarks()
+end
@@ -0,0 +1,44 @@
+require_relative 'base'
+
+class RamBenchmarks < KernelBenchmark
+    # Cycles per KB copied between banks by ram_copy,
+    # measured on the copies made by pspawn.
+    def benchmark_ram_copy
+        # Get symbols.
+        kernel_symbols = Zemu::Debug.load_map("kernel_debug.map")
+
+        copy_start = kernel_symbols.find_by_name("__ram_copy").address
+        copy_end = kernel_symbols.find_by_name("__ram_copy_done").address
+
+        # We expect to start executing at 0x8000,
+        # where the command-processor would reside normally.
+        @instance.break 0x8000, :program
+        
+        # Run, and expect to hit the breakpoint.
+        @instance.continue
+        @instance.remove_break 0x8000, :program
+
+        # Set a breakpoint at the start and end of the copy.
+        @instance.break copy_start, :program
+        @instance.break copy_end, :program
+
+        bench(5) do
+            # Skip small copies, whose cost is dominated by call overhead.
+            loop do
+                @instance.continue 10000000
+
+                # Byte count is passed in BC.
+                n = @instance.registers["BC"]
+
+                copy_cycles = @instance.continue 1000000
+
+                break (copy_cycles * 1024.0) / n if n >= 256
+            end
+        end
+    end
+end
+
+def benchmarks
+    b = RamBenchmarks.new
+    b.benchmarks()
+end
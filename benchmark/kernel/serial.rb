@@ -1,15 +1,13 @@
 require_relative 'base'
 
-class SerialBenchmarks < KernelBenchmark
-    def benchmark_serial_write
-        # Get symbols.
-        kernel_symbols = Zemu::Debug.load_map("kernel_debug.map")
-
-        swrite_start = kernel_symbols.find_by_name("_driver_6850_tx").address
-        swrite_end = kernel_symbols.find_by_name("_driver_6850_tx_done").address
-
-        puts "%04x, %04x" % [swrite_start, swrite_end]
+# The #6850 divides the clock by 64, so a byte with
+# a start and stop bit takes 64 * 10 cycles on the line.
+CLOCK = 3_686_400
+LINE_BYTE_CYCLES = 640
 
+class SerialBenchmarks < KernelBenchmark
+    # Runs until the benchmark program starts.
+    def run_to_program
         # We expect to start executing at 0x8000,
         # where the command-processor would reside normally.
         @instance.break 0x8000, :program
@@ -17,6 +15,22 @@ class SerialBenchmarks < KernelBenchmark
         # Run, and expect to hit the breakpoint.
         @instance.continue
         @instance.remove_break 0x8000, :program
+    end
+
+    def read16(address)
+        @instance.memory(address) | (@instance.memory(address + 1) << 8)
+    end
+
+    def benchmark_serial_write
+        # Get symbols.
+        kernel_symbols = Zemu::Debug.load_map("kernel_debug.map")
+
+        swrite_start = kernel_symbols.find_by_name("_do_swrite").address
+        swrite_end = kernel_symbols.find_by_name("__swrite_done").address
+
+        puts "%04x, %04x" % [swrite_start, swrite_end]
+
+        run_to_program
 
         # Set a breakpoint at the start and end of the ISR.
         @instance.break swrite_start, :program
@@ -29,6 +43,89 @@ class SerialBenchmarks < KernelBenchmark
             isr_cycles
         end
     end
+
+    # Bytes per second sent by a process writing as fast as it can,
+    # with the line running at its real speed.
+    def benchmark_serial_tx_rate
+        @unit = "bytes/s"
+
+        serial = @instance.device("serial")
+        serial.line_delay LINE_BYTE_CYCLES
+
+        run_to_program
+
+        bench(3) do
+            serial.get_byte while serial.transmitted_count > 0
+
+            cycles = @instance.continue CLOCK / 4
+
+            (serial.transmitted_count * CLOCK / cycles).to_f
+        end
+    end
+
+    # Bytes per second received by a process reading with sreadn, with
+    # the host sending as fast as the line and RTS allow. Fails if any
+    # bytes are lost, to the #6850 or to a full buffer.
+    def benchmark_serial_rx_rate
+        @unit = "bytes/s"
+        count = 1024
+
+        kernel_symbols = Zemu::Debug.load_map("kernel_debug.map")
+        program_symbols = Zemu::Debug.load_map("benchmark_serial_rx_rate.map")
+        stats = kernel_symbols.find_by_name("_terminal_stats").address
+        received = program_symbols.find_by_name("_received").address
+
+        serial = @instance.device("serial")
+        serial.line_delay LINE_BYTE_CYCLES
+
+        run_to_program
+
+        bench(3) do
+            start = read16(received)
+            @instance.serial_puts("U" * count)
+
+            cycles = 0
+            while read16(received) - start < count && cycles < CLOCK * 2
+                cycles += @instance.continue 10000
+            end
+
+            lost = count - (read16(received) - start)
+            if lost != 0
+                abort("Lost #{lost} bytes (#{serial.overruns} overruns, #{read16(stats)} dropped)")
+            end
+
+            (count * CLOCK / cycles).to_f
+        end
+    end
+
+    # Cycles from a byte arriving to a blocked reader having it,
+    # while another process runs the given program.
+    def bench_rx_latency(program)
+        program_symbols = Zemu::Debug.load_map("#{program}.map")
+        received = program_symbols.find_by_name("_received").address
+
+        run_to_program
+
+        bench(5) do
+            # Let the reader block again.
+            @instance.continue 200000
+
+            @instance.break received, :program
+            @instance.serial_puts "A"
+            latency = @instance.continue 10000000
+            @instance.remove_break received, :program
+
+            latency
+        end
+    end
+
+    def benchmark_serial_rx_latency_cpu
+        bench_rx_latency "benchmark_serial_rx_latency_cpu"
+    end
+
+    def benchmark_serial_rx_latency_disk
+        bench_rx_latency "benchmark_serial_rx_latency_disk"
+    end
 end
 
 def benchmarks
@@ -0,0 +1,37 @@
+#include <syscall.h>
+#include <string.h>
+
+#define IMAGE_SIZE 4096
+
+/* Version 2 header: 4KB of code at 0x8000, no data or BSS. */
+const char header[14] = {
+    0x0c, 0x80,
+    0x00, 0x80,
+    0x00, 0x10,
+    0x00, 0xd0, 0x00, 0x00,
+    0x00, 0xd0, 0x00, 0x00
+};
+
+char image[IMAGE_SIZE];
+
+void loop(void);
+
+void main()
+{
+    /* The same image as benchmark_load_exe. */
+    for (int i = 0; i < IMAGE_SIZE; i++) image[i] = (char)(i & 0xff);
+
+    int fd = syscall_fopen("test.exe", FMODE_WRITE);
+    syscall_fwrite(header, 14, fd);
+    syscall_fwrite(image, IMAGE_SIZE, fd);
+    syscall_fclose(fd);
+
+    /* The first load fills the image cache,
+     * the rest are copied from it. */
+    for (int i = 0; i < 6; i++)
+    {
+        syscall_pload("test.exe");
+    }
+
+    loop();
+}
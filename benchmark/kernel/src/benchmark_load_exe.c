@@ -0,0 +1,41 @@
+#include <syscall.h>
+#include <string.h>
+
+#define IMAGE_SIZE 4096
+
+/* Version 2 header: 4KB of code at 0x8000, no data or BSS. */
+const char header[14] = {
+    0x0c, 0x80,
+    0x00, 0x80,
+    0x00, 0x10,
+    0x00, 0xd0, 0x00, 0x00,
+    0x00, 0xd0, 0x00, 0x00
+};
+
+char image[IMAGE_SIZE];
+
+char name[] = "test0.exe";
+
+void loop(void);
+
+void main()
+{
+    /* The same image as benchmark_load_lz, stored uncompressed. */
+    for (int i = 0; i < IMAGE_SIZE; i++) image[i] = (char)(i & 0xff);
+
+    /* A different file each time, so no load is served
+     * from the image cache. */
+    for (int i = 0; i < 5; i++)
+    {
+        name[4] = (char)('0' + i);
+
+        int fd = syscall_fopen(name, FMODE_WRITE);
+        syscall_fwrite(header, 14, fd);
+        syscall_fwrite(image, IMAGE_SIZE, fd);
+        syscall_fclose(fd);
+
+        syscall_pload(name);
+    }
+
+    loop();
+}
@@ -0,0 +1,57 @@
+#include <syscall.h>
+#include <string.h>
+
+#define IMAGE_SIZE 4096
+#define BLOCK_SIZE 256
+
+/* Compressed version 2 header: 4KB of code at 0x8000, no data or BSS. */
+const char header[14] = {
+    0x0d, 0x80,
+    0x00, 0x80,
+    0x00, 0x10,
+    0x00, 0xd0, 0x00, 0x00,
+    0x00, 0xd0, 0x00, 0x00
+};
+
+char stream[BLOCK_SIZE + 32];
+
+char name[] = "test0.exe";
+
+void loop(void);
+
+void main()
+{
+    /* One block of 256 literals, then a match repeating
+     * it for the rest of the image. */
+    int n = 0;
+    int ext;
+
+    stream[n++] = (char)0xff;
+    stream[n++] = (char)(BLOCK_SIZE - 15);
+    for (int i = 0; i < BLOCK_SIZE; i++) stream[n++] = (char)i;
+
+    stream[n++] = (char)(BLOCK_SIZE & 0xff);
+    stream[n++] = (char)(BLOCK_SIZE >> 8);
+
+    for (ext = IMAGE_SIZE - BLOCK_SIZE - 4 - 15; ext >= 255; ext -= 255)
+    {
+        stream[n++] = (char)0xff;
+    }
+    stream[n++] = (char)ext;
+
+    /* A different file each time, so no load is served
+     * from the image cache. */
+    for (int i = 0; i < 5; i++)
+    {
+        name[4] = (char)('0' + i);
+
+        int fd = syscall_fopen(name, FMODE_WRITE);
+        syscall_fwrite(header, 14, fd);
+        syscall_fwrite(stream, n, fd);
+        syscall_fclose(fd);
+
+        syscall_pload(name);
+    }
+
+    loop();
+}
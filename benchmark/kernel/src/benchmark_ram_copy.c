@@ -0,0 +1,32 @@
+#include <syscall.h>
+#include <string.h>
+
+const char other_proc[4] = {
+    0x0a, 0x80,
+    0x18, 0xfe          /* infinite loop */
+};
+
+/* Long arguments, so that pspawn copies a few hundred bytes
+ * into the new process's bank. */
+char arg[100];
+char * args[4] = { arg, arg, arg, arg };
+
+void loop(void);
+
+void main()
+{
+    memset(arg, 'a', 99);
+    arg[99] = '\0';
+
+    int fd = syscall_fopen("test.exe", FMODE_WRITE);
+    syscall_fwrite(other_proc, 4, fd);
+    syscall_fclose(fd);
+
+    for (int i = 0; i < 5; i++)
+    {
+        int pd = syscall_pload("test.exe");
+        syscall_pspawn(pd, args, 4);
+    }
+
+    loop();
+}
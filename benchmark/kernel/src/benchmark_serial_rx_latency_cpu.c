@@ -0,0 +1,47 @@
+#include <stdio.h>
+
+volatile char c;
+volatile char spin;
+
+void smode(char mode) __naked
+{
+    mode;
+    __asm
+    ld      a, #32
+    rst     0x30
+    ret
+    __endasm;
+}
+
+int pclone(void) __naked
+{
+    __asm
+    ld      a, #70
+    rst     0x30
+    ret
+    __endasm;
+}
+
+/* The benchmark stops here once a byte has been read. */
+void received(void)
+{
+    spin = 0;
+}
+
+void main(void)
+{
+    /* Blocking mode, so the reader uses no CPU while it waits. */
+    smode(0x02);
+
+    /* The copy keeps the CPU busy. It does not have the terminal. */
+    if (pclone() == 0)
+    {
+        while (1) spin++;
+    }
+
+    while (1)
+    {
+        c = getchar();
+        received();
+    }
+}
@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <syscall.h>
+
+volatile char c;
+volatile char spin;
+
+char sector[512];
+
+void smode(char mode) __naked
+{
+    mode;
+    __asm
+    ld      a, #32
+    rst     0x30
+    ret
+    __endasm;
+}
+
+int pclone(void) __naked
+{
+    __asm
+    ld      a, #70
+    rst     0x30
+    ret
+    __endasm;
+}
+
+/* The benchmark stops here once a byte has been read. */
+void received(void)
+{
+    spin = 0;
+}
+
+void main(void)
+{
+    /* Blocking mode, so the reader uses no CPU while it waits. */
+    smode(0x02);
+
+    /* The copy keeps the disk busy. It does not have the terminal. */
+    if (pclone() == 0)
+    {
+        while (1)
+        {
+            /* Files cannot be opened for writing over an existing one. */
+            syscall_fdelete("latency.txt");
+
+            int fd = syscall_fopen("latency.txt", FMODE_WRITE);
+            if (fd < 0)
+            {
+                printf("fopen failed: %d\r\n", fd);
+                return;
+            }
+
+            for (int i = 0; i < 8; i++) syscall_fwrite(sector, sizeof(sector), fd);
+            syscall_fclose(fd);
+        }
+    }
+
+    while (1)
+    {
+        c = getchar();
+        received();
+    }
+}
@@ -0,0 +1,34 @@
+#include <stddef.h>
+#include <stdint.h>
+
+char buf[32];
+
+/* Bytes received so far, read by the benchmark. */
+volatile uint16_t received;
+
+uint16_t sreadn_ret;
+
+/* sreadn takes min on the stack, directly above the syscall's
+ * return address, so take our own return address off first. */
+int sreadn(char * b, size_t max, size_t min) __naked
+{
+    b; max; min;
+    __asm
+    pop     bc
+    ld      (_sreadn_ret), bc
+    ld      a, #76
+    rst     0x30
+    ld      hl, (_sreadn_ret)
+    jp      (hl)
+    __endasm;
+}
+
+void main(void)
+{
+    received = 0;
+
+    while (1)
+    {
+        received += sreadn(buf, sizeof(buf), 1);
+    }
+}
@@ -0,0 +1,24 @@
+#include <stddef.h>
+
+char line[64];
+
+/* swrite, without depending on the standard library's wrapper. */
+size_t swrite(const char * s, size_t count) __naked
+{
+    s; count;
+    __asm
+    ld      a, #0
+    rst     0x30
+    ret
+    __endasm;
+}
+
+void main(void)
+{
+    for (int i = 0; i < sizeof(line); i++) line[i] = 'a';
+
+    while (1)
+    {
+        swrite(line, sizeof(line));
+    }
+}
@@ -0,0 +1,20 @@
+/* sysinfo does no work beyond returning a pointer,
+ * so it measures the cost of the syscall handler. */
+void null_syscall(void) __naked
+{
+    __asm
+    ld      a, #34
+    rst     0x30
+    .globl  _null_syscall_ret
+_null_syscall_ret:
+    ret
+    __endasm;
+}
+
+void main(void)
+{
+    while (1)
+    {
+        null_syscall();
+    }
+}
@@ -0,0 +1,35 @@
+require_relative 'base'
+
+class SyscallBenchmarks < KernelBenchmark
+    # Cycles from a process issuing a syscall which does
+    # nothing to it getting control back.
+    def benchmark_syscall_null
+        program_symbols = Zemu::Debug.load_map("benchmark_syscall_null.map")
+
+        syscall_start = program_symbols.find_by_name("_null_syscall").address
+        syscall_end = program_symbols.find_by_name("_null_syscall_ret").address
+
+        # We expect to start executing at 0x8000,
+        # where the command-processor would reside normally.
+        @instance.break 0x8000, :program
+        
+        # Run, and expect to hit the breakpoint.
+        @instance.continue
+        @instance.remove_break 0x8000, :program
+
+        @instance.break syscall_start, :program
+        @instance.break syscall_end, :program
+
+        bench(10) do
+            @instance.continue 10000
+            syscall_cycles = @instance.continue 10000
+
+            syscall_cycles
+        end
+    end
+end
+
+def benchmarks
+    b = SyscallBenchmarks.new
+    b.benchmarks()
+end
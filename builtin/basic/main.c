@@ -20,6 +20,8 @@ tok_t statement[256];
 
 FILE thefile;
 
+int syscall_readline(char * buf, size_t max);
+
 /* NASTY!!! */
 #define main(_argc, _argv) user_main(_argv, _argc)
 #define ARG_LIM 1
@@ -101,7 +103,15 @@ int main(size_t argc, char ** argv)
     while (1)
     {
         printf("> ");
+
+#ifdef Z80
+        /* The kernel edits the line, and BASIC is only
+         * woken once it is finished. If input is piped in,
+         * stop at the end of it. */
+        if (syscall_readline(input, sizeof(input)) < 0) return 0;
+#else
         gets(input);
+#endif
 
         process_line();
     }
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "output.h"
+
+#ifdef Z80
+
+/* One piece of a scatter-gather write. */
+typedef struct _IOVEC
+{
+    const char * ptr;
+    size_t len;
+} IOVEC;
+
+size_t syscall_swritev(IOVEC * iov, size_t count);
+
+/* Enough for a PRINT of a few strings and numbers in one write. */
+#define OUTPUT_PIECES 16
+#define OUTPUT_CHARS 40
+
+IOVEC output_pieces[OUTPUT_PIECES];
+size_t output_count;
+
+/* Characters are copied here, as they have nowhere else to live. */
+char output_chars[OUTPUT_CHARS];
+size_t output_used;
+
+void output_flush(void)
+{
+    if (output_count != 0) syscall_swritev(output_pieces, output_count);
+
+    output_count = 0;
+    output_used = 0;
+}
+
+void output_str(const char * s)
+{
+    if (output_count == OUTPUT_PIECES) output_flush();
+
+    output_pieces[output_count].ptr = s;
+    output_pieces[output_count].len = strlen(s);
+    output_count++;
+
+    if (strchr(s, '\n') != NULL) output_flush();
+}
+
+void output_char(char c)
+{
+    if (output_used == OUTPUT_CHARS) output_flush();
+
+    /* Extend the last piece if it ends with the last character added. */
+    IOVEC * last = output_count != 0 ? &output_pieces[output_count - 1] : NULL;
+    if (last != NULL && last->ptr + last->len == &output_chars[output_used])
+    {
+        last->len++;
+    }
+    else
+    {
+        if (output_count == OUTPUT_PIECES) output_flush();
+
+        output_pieces[output_count].ptr = &output_chars[output_used];
+        output_pieces[output_count].len = 1;
+        output_count++;
+    }
+
+    output_chars[output_used++] = c;
+
+    if (c == '\n') output_flush();
+}
+
+void output_int(int16_t n)
+{
+    char digits[5];
+    uint8_t count = 0;
+
+    /* Work in unsigned so that -32768 can be negated. */
+    uint16_t u = (uint16_t)n;
+    if (n < 0)
+    {
+        output_char('-');
+        u = (uint16_t)-u;
+    }
+
+    do
+    {
+        digits[count++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+
+    while (count != 0) output_char(digits[--count]);
+}
+
+#else
+
+void output_flush(void)
+{
+    fflush(stdout);
+}
+
+void output_str(const char * s)
+{
+    fputs(s, stdout);
+}
+
+void output_char(char c)
+{
+    putchar(c);
+}
+
+void output_int(int16_t n)
+{
+    printf("%d", n);
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef _OUTPUT_H
+#define _OUTPUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Line-buffered terminal output, as used by the command processor.
+ *
+ * Output is collected as a list of pieces, and written with a
+ * single swritev once a newline is added, rather than with a
+ * syscall for every string or character. On the desktop it is
+ * written straight to stdout.
+ */
+
+/* Adds a string. It is not copied, so it must
+ * not change until the output is flushed. */
+void output_str(const char * s);
+
+/* Adds a character. */
+void output_char(char c);
+
+/* Adds a signed number. */
+void output_int(int16_t n);
+
+/* Writes everything added so far. */
+void output_flush(void);
+
+#endif /* _OUTPUT_H */
@@ -0,0 +1,23 @@
+    ; Wrappers for syscalls used by BASIC
+    ; which are not provided by the standard library.
+    ;
+    ; Parameters are passed in HL and DE according to the
+    ; SDCC version 1 calling convention, which is also how the
+    ; kernel expects to receive them. Return values are in DE.
+
+    .equ    READLINE, 74
+    .equ    SWRITEV, 78
+
+    ; int syscall_readline(char * buf, size_t max)
+    .globl  _syscall_readline
+_syscall_readline:
+    ld      A, #READLINE
+    rst     0x30
+    ret
+
+    ; size_t syscall_swritev(IOVEC * iov, size_t count)
+    .globl  _syscall_swritev
+_syscall_swritev:
+    ld      A, #SWRITEV
+    rst     0x30
+    ret
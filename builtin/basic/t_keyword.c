@@ -4,6 +4,7 @@
 #include "errors.h"
 #include "program.h"
 #include "eval.h"
+#include "output.h"
 #include "statement.h"
 
 #include "t_defs.h"
@@ -127,9 +128,10 @@ error_t do_print_string(const tok_t * toks, const tok_t ** end)
 {
     const tok_t * string_end = t_varlen_skip(toks);
 
-    /* String is null-terminated so just print directly. */
+    /* String is null-terminated so just print directly.
+     * It stays put until do_print flushes the line. */
     toks += 2;
-    printf("%s", (const char *)toks);
+    output_str((const char *)toks);
 
     *end = string_end;
     return ERROR_NOERROR;
@@ -145,7 +147,7 @@ error_t do_print_numeric(const tok_t * toks, const tok_t ** end)
     if (e != ERROR_NOERROR) return e;
 
     /* Print the result. */
-    printf("%d", result);
+    output_int(result);
 
     *end = expr_end;
     return ERROR_NOERROR;
@@ -159,15 +161,15 @@ error_t do_print(const tok_t * toks)
          * or a variable.
          */
         const tok_t * end;
-        if (*toks == TOK_STRING)
-        {
-            error_t e = do_print_string(toks, &end);
-            if (e != ERROR_NOERROR) return e;
-        }
-        else
+        error_t e;
+        if (*toks == TOK_STRING) e = do_print_string(toks, &end);
+        else e = do_print_numeric(toks, &end);
+
+        /* Write what was printed before the error is reported. */
+        if (e != ERROR_NOERROR)
         {
-            error_t e = do_print_numeric(toks, &end);
-            if (e != ERROR_NOERROR) return e;
+            output_flush();
+            return e;
         }
 
         /* Set token pointer to terminator/separator. */
@@ -177,14 +179,18 @@ error_t do_print(const tok_t * toks)
          * If not then the next token must be a separator.
          */
         if (*toks == TOK_TERMINATOR) break;
-        if (*toks != TOK_SEPARATOR) return ERROR_SYNTAX;
+        if (*toks != TOK_SEPARATOR)
+        {
+            output_flush();
+            return ERROR_SYNTAX;
+        }
 
         /* Skip separator so that we evaluate the next expression */
         toks += SEP_SIZE;
     }
 
-    putchar('\r');
-    putchar('\n');
+    /* The line ending writes the whole line in one syscall. */
+    output_str("\r\n");
 
     return ERROR_NOERROR;
 }
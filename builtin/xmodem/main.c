@@ -7,7 +7,23 @@
 #define NAK 0x15
 #define EOT 0x04
 
-char data[128];
+/* Packet number, its complement, 128 data bytes and the checksum. */
+#define PACKET_SIZE 131
+
+char packet[PACKET_SIZE];
+
+int syscall_sreadn(char * buf, size_t max, size_t min);
+
+/* Reads exactly count bytes, in as few syscalls as the input allows. */
+static void receive(char * buf, size_t count)
+{
+    while (count != 0)
+    {
+        int n = syscall_sreadn(buf, count, count);
+        buf += n;
+        count -= n;
+    }
+}
 
 int user_main(char ** argv, size_t argc)
 {
@@ -35,27 +51,17 @@ int user_main(char ** argv, size_t argc)
     while (1)
     {
         /* Get header. */
-        uint8_t header = getchar();
+        char header;
+        receive(&header, 1);
 
         /* End of transmission? */
         if (header == EOT) break;
 
-        /* Get packet number. */
-        getchar();
-        getchar();
-
-        /* Get data - 128 bytes. */
-        for (uint8_t i = 0; i < 128; i++)
-        {
-            char c = getchar();
-            data[i] = c;
-        }
-
-        /* Get checksum. */
-        getchar();
+        /* Get the rest of the packet. */
+        receive(packet, PACKET_SIZE);
 
         /* Write data to file. */
-        syscall_fwrite(data, 128, fd);
+        syscall_fwrite(packet + 2, 128, fd);
 
         /* Now send ACK. */
         putchar(ACK);
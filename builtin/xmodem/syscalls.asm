@@ -0,0 +1,21 @@
+    ; Wrappers for syscalls used by xmodem
+    ; which are not provided by the standard library.
+
+    .equ    SREADN, 76
+
+    ; int syscall_sreadn(char * buf, size_t max, size_t min)
+    ;
+    ; min is passed on the stack, and the kernel cleans it up.
+    ; The kernel expects it directly above the syscall's return
+    ; address, so take our own return address off first.
+    .globl  _syscall_sreadn
+_syscall_sreadn:
+    pop     BC
+    ld      (__sreadn_ret), BC
+    ld      A, #SREADN
+    rst     0x30
+    ld      HL, (__sreadn_ret)
+    jp      (HL)
+
+__sreadn_ret:
+    .word   0
@@ -3,6 +3,7 @@
 #include <string.h>
 
 #include "dir.h"
+#include "output.h"
 
 int command_dir(char ** argv, size_t argc)
 {
@@ -13,31 +14,40 @@ int command_dir(char ** argv, size_t argc)
 
     uint16_t file_entries = syscall_fentries();
 
-    printf("%u files:\n\r", file_entries);
+    output_uint(file_entries, 0, ' ');
+    output_str(" files:\n\r");
 
     for (uint16_t f = 0; f < file_entries; f++)
     {
         int error = syscall_fentry(&filename[0], f);
         if (error == 0)
         {
-            puts("    ");
-            puts(&filename[0]);
-            for (uint8_t i = strlen(&filename[0]); i < 20; i++) putchar(' ');
+            /* Each entry is written as one line, with one syscall. */
+            output_str("    ");
+            output_str(&filename[0]);
+            for (uint8_t i = strlen(&filename[0]); i < 20; i++) output_char(' ');
 
             syscall_finfo(&filename[0], &finfo);
             
-            if (finfo.attr & FATTR_SYS)   putchar('s');
-            else                          putchar('~');
+            if (finfo.attr & FATTR_SYS)   output_char('s');
+            else                          output_char('~');
 
-            if (finfo.attr & FATTR_HID)   putchar('h');
-            else                          putchar('~');
+            if (finfo.attr & FATTR_HID)   output_char('h');
+            else                          output_char('~');
 
-            if (finfo.attr & FATTR_RO)    putchar('r');
-            else                          putchar('~');
+            if (finfo.attr & FATTR_RO)    output_char('r');
+            else                          output_char('~');
 
-            printf("  %5u", (uint16_t)finfo.size); /* Won't handle files more than 65536 in size. */
+            output_str("  ");
+            output_uint((uint16_t)finfo.size, 5, ' '); /* Won't handle files more than 65536 in size. */
 
-            printf("  %04u-%02u-%02u\n\r", finfo.created_year, (uint16_t)finfo.created_month, (uint16_t)finfo.created_day);
+            output_str("  ");
+            output_uint(finfo.created_year, 4, '0');
+            output_char('-');
+            output_uint(finfo.created_month, 2, '0');
+            output_char('-');
+            output_uint(finfo.created_day, 2, '0');
+            output_str("\n\r");
         }
         else
         {
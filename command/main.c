@@ -22,6 +22,7 @@
 #include <setjmp.h>
 
 #include "utils.h"
+#include "syscalls.h"
 
 #include "zebra.h"
 
@@ -32,11 +33,13 @@
 #include "type.h"
 #include "load.h"
 #include "del.h"
+#include "ps.h"
 
 char input[256];
 char * cmd;
 char * argv[16];
 size_t argc;
+char * pipe_argv[16];
 char program[16];
 
 char temp[512];
@@ -69,7 +72,7 @@ void cancel(uint16_t address)
 
 typedef int (*Command_T)(char **, size_t);
 
-#define NUM_COMMANDS 6
+#define NUM_COMMANDS 7
 
 typedef struct _Inbuilt
 {
@@ -102,6 +105,10 @@ const Inbuilt_T commands[NUM_COMMANDS] =
     {
         "DEL",
         &command_del
+    },
+    {
+        "PS",
+        &command_ps
     }
 };
 
@@ -119,6 +126,96 @@ const Inbuilt_T * get_command(void)
     return NULL;
 }
 
+/* Loads the program named by the command,
+ * reporting any error. Returns process descriptor, or <0. */
+int load(char * name)
+{
+    size_t cmd_len = strlen(name);
+    if (cmd_len > 8) cmd_len = 8;
+
+    /* Construct name of file to load. */
+    memcpy(program, name, cmd_len);
+    program[cmd_len] = '.';
+    memcpy(&program[cmd_len+1], "EXE", 4);
+
+    int pd = syscall_pload(program);
+
+    if (pd == E_FILENOTFOUND)
+    {
+        printf("%s could not be found.\n\r", program);
+    }
+    else if (pd < 0)
+    {
+        printf("Error occurred loading program %s: %d\n\r", program, pd);
+    }
+
+    return pd;
+}
+
+/* Runs "left | right", with the output of the program on
+ * the left going to the input of the program on the right.
+ * Returns the exit code of the program on the right.
+ */
+int run_pipe(char * left, char * right)
+{
+    parse(left);
+    if (cmd == NULL) return -1;
+    utils_toupper(cmd);
+
+    /* Keep the writer's arguments while the reader's are parsed. */
+    memcpy(pipe_argv, argv, sizeof(argv));
+    size_t pipe_argc = argc;
+
+    int writer = load(cmd);
+    if (writer < 0) return writer;
+
+    /* Neither program is run if the other cannot be,
+     * so release whatever has been loaded. */
+    parse(right);
+    if (cmd == NULL)
+    {
+        syscall_pfree(writer);
+        return -1;
+    }
+    utils_toupper(cmd);
+
+    int reader = load(cmd);
+    if (reader < 0)
+    {
+        syscall_pfree(writer);
+        return reader;
+    }
+
+    int p = syscall_pipe();
+    if (p < 0)
+    {
+        printf("Could not create pipe: %d\n\r", p);
+        syscall_pfree(writer);
+        syscall_pfree(reader);
+        return p;
+    }
+
+    syscall_predirect(writer, PIPE_NONE, p);
+    syscall_predirect(reader, p, PIPE_NONE);
+
+    /* Keyboard input goes to the reader, and comes back here when it
+     * exits. Neither process takes it when spawned, as this process
+     * no longer has it. */
+    syscall_sactive(reader);
+
+    syscall_pspawn(writer, pipe_argv, pipe_argc);
+    int exitcode = syscall_pexec(reader, argv, argc);
+
+    /* The reader may stop before the writer has finished. */
+    PINFO info;
+    while (syscall_pinfo(writer, &info) == 0 && info.state != PSTATE_FINISHED)
+    {
+        syscall_pyield();
+    }
+
+    return exitcode;
+}
+
 void user_main(void)
 {
     const SysInfo_T * sysinfo = syscall_sysinfo();
@@ -150,8 +247,20 @@ void user_main(void)
         if (code == -1) puts("\r\nProgram cancelled by user.\r\n");
         printf("(%d) > ", code);
 
-        /* Get user input and parse into cmd and argv */
-        gets(input);
+        /* Get user input and parse into cmd and argv.
+         * The kernel edits the line, and the shell is only
+         * woken once it is finished. If input is piped in,
+         * stop at the end of it. */
+        if (syscall_readline(input, sizeof(input)) < 0) return;
+
+        char * bar = strchr(input, '|');
+        if (bar != NULL)
+        {
+            *bar = '\0';
+            exitcode = run_pipe(input, bar + 1);
+            continue;
+        }
+
         parse(input);
 
         utils_toupper(cmd);
@@ -160,28 +269,8 @@ void user_main(void)
         
         if (command_to_run == NULL)
         {
-            size_t cmd_len = strlen(cmd);
-            if (cmd_len > 8) cmd_len = 8;
-
-            /* Construct name of file to load. */
-            memcpy(program, cmd, cmd_len);
-            program[cmd_len] = '.';
-            memcpy(&program[cmd_len+1], "EXE", 4);
-
-            int pd = syscall_pload(program);
-
-            if (pd == E_FILENOTFOUND)
-            {
-                printf("%s could not be found.\n\r", program);
-            }
-            else if (pd < 0)
-            {
-                printf("Error occurred loading program %s: %d\n\r", program, pd);
-            }
-            else
-            {
-                exitcode = syscall_pexec(pd, argv, argc);
-            }
+            int pd = load(cmd);
+            if (pd >= 0) exitcode = syscall_pexec(pd, argv, argc);
         }
         else
         {
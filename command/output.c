@@ -0,0 +1,75 @@
+#include <string.h>
+
+#include "output.h"
+#include "syscalls.h"
+
+/* Enough for a whole dir line, which needs 8 pieces and up to
+ * 37 characters: 19 of padding, 3 attributes, 5 digits of size
+ * and 10 of date. */
+#define OUTPUT_PIECES 16
+#define OUTPUT_CHARS 40
+
+IOVEC output_pieces[OUTPUT_PIECES];
+size_t output_count;
+
+/* Characters are copied here, as they have nowhere else to live. */
+char output_chars[OUTPUT_CHARS];
+size_t output_used;
+
+void output_flush(void)
+{
+    if (output_count != 0) syscall_swritev(output_pieces, output_count);
+
+    output_count = 0;
+    output_used = 0;
+}
+
+void output_str(const char * s)
+{
+    if (output_count == OUTPUT_PIECES) output_flush();
+
+    output_pieces[output_count].ptr = s;
+    output_pieces[output_count].len = strlen(s);
+    output_count++;
+
+    if (strchr(s, '\n') != NULL) output_flush();
+}
+
+void output_char(char c)
+{
+    if (output_used == OUTPUT_CHARS) output_flush();
+
+    /* Extend the last piece if it ends with the last character added. */
+    IOVEC * last = output_count != 0 ? &output_pieces[output_count - 1] : NULL;
+    if (last != NULL && last->ptr + last->len == &output_chars[output_used])
+    {
+        last->len++;
+    }
+    else
+    {
+        if (output_count == OUTPUT_PIECES) output_flush();
+
+        output_pieces[output_count].ptr = &output_chars[output_used];
+        output_pieces[output_count].len = 1;
+        output_count++;
+    }
+
+    output_chars[output_used++] = c;
+
+    if (c == '\n') output_flush();
+}
+
+void output_uint(uint16_t n, uint8_t width, char pad)
+{
+    char digits[5];
+    uint8_t count = 0;
+
+    do
+    {
+        digits[count++] = (char)('0' + n % 10);
+        n /= 10;
+    } while (n != 0);
+
+    for (uint8_t i = count; i < width; i++) output_char(pad);
+    while (count != 0) output_char(digits[--count]);
+}
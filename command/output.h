@@ -0,0 +1,27 @@
+#ifndef _OUTPUT_H
+#define _OUTPUT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Line-buffered terminal output.
+ *
+ * Output is collected as a list of pieces, and written with a
+ * single swritev once a newline is added, rather than with a
+ * syscall for every string or character.
+ */
+
+/* Adds a string. It is not copied, so it must
+ * not change until the output is flushed. */
+void output_str(const char * s);
+
+/* Adds a character. */
+void output_char(char c);
+
+/* Adds an unsigned number, padded on the left with pad to width. */
+void output_uint(uint16_t n, uint8_t width, char pad);
+
+/* Writes everything added so far. */
+void output_flush(void);
+
+#endif /* _OUTPUT_H */
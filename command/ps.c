@@ -0,0 +1,41 @@
+#include <stdio.h>
+
+#include "ps.h"
+#include "syscalls.h"
+
+#define PROCS_MAX 16
+
+const char * const state_names[] =
+{
+    "RUN  ",
+    "READY",
+    "DONE ",
+    "-    ",
+    "BLOCK"
+};
+
+int command_ps(char ** argv, size_t argc)
+{
+    argv; argc;
+
+    PINFO info;
+
+    puts("PID  STATE  BANK  TICKS  SYSCALLS  RD     WR     TX\n\r");
+
+    for (int pid = 0; pid < PROCS_MAX; pid++)
+    {
+        if (syscall_pinfo(pid, &info) != 0) continue;
+
+        printf("%3d  %s  %4u  %5u  %8u  %5u  %5u  %5u\n\r",
+            pid,
+            state_names[info.state],
+            (uint16_t)info.bank,
+            info.ticks,
+            info.syscalls,
+            info.sectors_read,
+            info.sectors_written,
+            info.bytes_written);
+    }
+
+    return 0;
+}
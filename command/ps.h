@@ -0,0 +1,8 @@
+#ifndef _PS_H
+#define _PS_H
+
+#include <stddef.h>
+
+int command_ps(char ** argv, size_t argc);
+
+#endif /* _PS_H */
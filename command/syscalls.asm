@@ -0,0 +1,81 @@
+    ; Wrappers for syscalls used by the command processor
+    ; which are not provided by the standard library.
+    ;
+    ; Parameters are passed in HL and DE according to the
+    ; SDCC version 1 calling convention, which is also how the
+    ; kernel expects to receive them. Return values are in DE.
+
+    .equ    PYIELD, 46
+    .equ    PINFO, 48
+    .equ    PIPE, 66
+    .equ    PREDIRECT, 68
+    .equ    SACTIVE, 72
+    .equ    READLINE, 74
+    .equ    SWRITEV, 78
+    .equ    PFREE, 84
+
+    ; int syscall_pinfo(int pid, PINFO * buf)
+    .globl  _syscall_pinfo
+_syscall_pinfo:
+    ld      A, #PINFO
+    rst     0x30
+    ret
+
+    ; void syscall_pyield(void)
+    .globl  _syscall_pyield
+_syscall_pyield:
+    ld      A, #PYIELD
+    rst     0x30
+    ret
+
+    ; int syscall_pipe(void)
+    .globl  _syscall_pipe
+_syscall_pipe:
+    ld      A, #PIPE
+    rst     0x30
+    ret
+
+    ; int syscall_predirect(int pd, int in, int out)
+    ;
+    ; out is passed on the stack, and the kernel cleans it up.
+    ; The kernel expects it directly above the syscall's return
+    ; address, so take our own return address off first.
+    .globl  _syscall_predirect
+_syscall_predirect:
+    pop     BC
+    ld      (__predirect_ret), BC
+    ld      A, #PREDIRECT
+    rst     0x30
+    ld      HL, (__predirect_ret)
+    jp      (HL)
+
+__predirect_ret:
+    .word   0
+
+    ; int syscall_pfree(int pd)
+    .globl  _syscall_pfree
+_syscall_pfree:
+    ld      A, #PFREE
+    rst     0x30
+    ret
+
+    ; int syscall_sactive(int pid)
+    .globl  _syscall_sactive
+_syscall_sactive:
+    ld      A, #SACTIVE
+    rst     0x30
+    ret
+
+    ; int syscall_readline(char * buf, size_t max)
+    .globl  _syscall_readline
+_syscall_readline:
+    ld      A, #READLINE
+    rst     0x30
+    ret
+
+    ; size_t syscall_swritev(IOVEC * iov, size_t count)
+    .globl  _syscall_swritev
+_syscall_swritev:
+    ld      A, #SWRITEV
+    rst     0x30
+    ret
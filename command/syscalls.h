@@ -0,0 +1,79 @@
+#ifndef _SYSCALLS_H
+#define _SYSCALLS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Process states, as returned in PINFO. */
+#define PSTATE_RUNNING  0
+#define PSTATE_READY    1
+#define PSTATE_FINISHED 2
+#define PSTATE_FREE     3
+#define PSTATE_BLOCKED  4
+
+/* Information about a process. Counters wrap on overflow. */
+typedef struct _PINFO
+{
+    int8_t state;
+    uint8_t bank;
+    uint16_t base_address;
+
+    uint16_t syscalls;
+    uint16_t ticks;
+    uint16_t sectors_read;
+    uint16_t sectors_written;
+    uint16_t bytes_written;
+} PINFO;
+
+/* Gets information about the process with given ID.
+ * Returns 0 on success, <0 if there is no such process.
+ */
+int syscall_pinfo(int pid, PINFO * buf);
+
+/* Gives up the rest of the current time slice. */
+void syscall_pyield(void);
+
+/* No pipe, i.e. the terminal. */
+#define PIPE_NONE -1
+
+/* Creates a pipe.
+ * Returns the ID of the pipe, or <0 if none are free.
+ */
+int syscall_pipe(void);
+
+/* Connects the input and output of a loaded process to pipes,
+ * or to the terminal with PIPE_NONE.
+ * Returns 0 on success, <0 on error.
+ */
+int syscall_predirect(int pd, int in, int out);
+
+/* Releases a process which has been loaded but not spawned.
+ * Returns 0 on success, <0 if there is no such process.
+ */
+int syscall_pfree(int pd);
+
+/* Gives the active terminal, which receives keyboard input,
+ * to the given process. It comes back when that process exits.
+ * Returns the process which had it, or <0 if none did or on error.
+ */
+int syscall_sactive(int pid);
+
+/* Reads a line from the terminal, echoed and edited by the kernel.
+ * Returns the length of the line, without the line ending.
+ */
+int syscall_readline(char * buf, size_t max);
+
+/* One piece of a scatter-gather write. */
+typedef struct _IOVEC
+{
+    const char * ptr;
+    size_t len;
+} IOVEC;
+
+/* Writes count pieces to the terminal in one syscall.
+ * A piece may be updated if the write has to wait part way through.
+ * Returns count.
+ */
+size_t syscall_swritev(IOVEC * iov, size_t count);
+
+#endif /* _SYSCALLS_H */
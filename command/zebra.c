@@ -3,6 +3,9 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+
+#include "syscalls.h"
 
 const uint32_t zebra_pattern[ZEBRA_LINES] =
 {
@@ -79,7 +82,13 @@ void zebra_display(void)
 
     *zebra_image_ptr = '\0';
 
-    puts(zebra_image);
+    /* Picture and caption in one syscall. */
+    IOVEC iov[2] = {
+        { zebra_image, 0 },
+        { "\r\nZeus the Zebra by Katie Buttriss.\r\n\r\n", 0 }
+    };
+    iov[0].len = strlen(iov[0].ptr);
+    iov[1].len = strlen(iov[1].ptr);
 
-    puts("\r\nZeus the Zebra by Katie Buttriss.\r\n\r\n");
+    syscall_swritev(iov, 2);
 }
@@ -10,6 +10,13 @@
 
     .equ    DISKPORT, 0x18
 
+    ; Offsets into ProcessDescriptor_T.
+    ; Must match ProcessStats_T in include/process.h.
+    .equ    PSTAT_SECTORS_READ, 4
+    .equ    PSTAT_SECTORS_WRITTEN, 6
+
+    .globl  _process_current_ptr
+
     ; **************************
     ; PUBLIC ROUTINES
     ;
@@ -70,6 +77,16 @@ _disk_read:
 
     call    _status_clr_disk
 
+    ; Count the sector against the current process.
+    ld      HL, (_process_current_ptr)
+    ld      BC, #PSTAT_SECTORS_READ
+    add     HL, BC
+    inc     (HL)
+    jp      nz, __disk_read_counted
+    inc     HL
+    inc     (HL)
+__disk_read_counted:
+
     jp      (IY)
 
 
@@ -102,6 +119,16 @@ _disk_write:
 
     call    _status_clr_disk
 
+    ; Count the sector against the current process.
+    ld      HL, (_process_current_ptr)
+    ld      BC, #PSTAT_SECTORS_WRITTEN
+    add     HL, BC
+    inc     (HL)
+    jp      nz, __disk_write_counted
+    inc     HL
+    inc     (HL)
+__disk_write_counted:
+
     jp      (IY)
 
     
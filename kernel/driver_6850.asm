@@ -37,3 +37,12 @@ _driver_6850_tx_loop:
 _driver_6850_tx_done:
     pop     IX
     ret
+
+    ; driver_6850_control(uint8_t control)
+    ;
+    ; control will be in A
+    ;
+    .globl  _driver_6850_control
+_driver_6850_control:
+    out     (UART_PORT_CONTROL), A
+    ret
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 
 #include <include/file.h>
+#include <include/memory.h>
 
 #define CLUSTER_EOF 0xffff
 #define CLUSTER_FREE 0x0000
@@ -691,6 +692,9 @@ int file_delete(const char * filename)
 
     uint16_t cluster = direntry.starting_cluster;
 
+    /* A new file may reuse the clusters, so forget any cached image. */
+    memory_cache_invalidate(cluster);
+
     /* De-allocate each cluster allocated to this file. */
     while (cluster != CLUSTER_EOF)
     {
@@ -900,6 +904,22 @@ size_t file_write(char * ptr, size_t n, int fd)
     return bytes;
 }
 
+size_t file_writev(const IOVec_T * iov, size_t count, int fd)
+{
+    size_t bytes = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t n = file_write((char *)iov[i].ptr, iov[i].len, fd);
+        bytes += n;
+
+        /* Stop at the first error. */
+        if (n != iov[i].len) break;
+    }
+
+    return bytes;
+}
+
 size_t file_read(char * ptr, size_t n, int fd)
 {
 #ifndef UNIT_TEST
@@ -6,6 +6,8 @@
 
 #include <syscall.h>
 
+#include <include/iovec.h>
+
 #define KERNEL_EOF -1
 
 #define FD_FLAGS_CLAIMED 0x01
@@ -68,6 +70,7 @@ int file_open(const char * filename, uint8_t mode);
 int file_readbyte(int fd);
 size_t file_read(char * ptr, size_t n, int fd);
 size_t file_write(char * ptr, size_t n, int fd);
+size_t file_writev(const IOVec_T * iov, size_t count, int fd);
 void file_close(int fd);
 int file_info(const char * filename, FINFO * finfo);
 int file_entry(char * s, uint16_t entry);
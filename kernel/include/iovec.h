@@ -0,0 +1,13 @@
+#ifndef _IOVEC_H
+#define _IOVEC_H
+
+#include <stddef.h>
+
+/* One piece of a scatter-gather write. */
+typedef struct _IOVec_T
+{
+    const char * ptr;
+    size_t len;
+} IOVec_T;
+
+#endif /* _IOVEC_H */
@@ -0,0 +1,54 @@
+#ifndef _LZ_H
+#define _LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* LZ decompression for compressed executables.
+ *
+ * The stream is a sequence of LZ4-style blocks. Each starts with a
+ * token byte: the high nibble is the number of literal bytes and the
+ * low nibble is the match length minus 4. A nibble of 15 is extended
+ * by the following bytes, each added to it, until one is not 255.
+ *
+ *     token, [literal length bytes], literals,
+ *     offset (16-bit little-endian), [match length bytes]
+ *
+ * The match copies from offset bytes back in the output, and may
+ * overlap the bytes it is producing. The stream for a segment ends as
+ * soon as the expected number of bytes has been produced, so the last
+ * block may stop after its literals.
+ */
+
+#define E_LZCORRUPT -1
+
+/* lz_begin
+ *
+ * Purpose:
+ *     Starts reading compressed data from an open file.
+ * 
+ * Parameters:
+ *     fd: File descriptor, positioned at the start of the stream.
+ * 
+ * Returns:
+ *     Nothing.
+ */
+void lz_begin(int fd);
+
+/* lz_decode
+ *
+ * Purpose:
+ *     Decompresses the next segment of the stream.
+ *     Input is read from the file in small chunks as it is needed.
+ * 
+ * Parameters:
+ *     dst:  Where to write the decompressed bytes.
+ *     size: Number of bytes to produce.
+ * 
+ * Returns:
+ *     0 on success, or E_LZCORRUPT if the stream is truncated or
+ *     would write outside the segment.
+ */
+int lz_decode(char * dst, uint16_t size);
+
+#endif /* _LZ_H */
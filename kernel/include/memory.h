@@ -7,6 +7,11 @@
 #define E_NOPAGES -1
 #define E_INIT -2
 
+/* Returned by the shared bank syscalls, so distinct
+ * from the process error codes. */
+#define E_NOSHARED -7
+#define E_NOTGRANTED -8
+
 /* Page disabled, e.g. because of lack of memory. */
 #define PAGE_DISABLED 0x00
 
@@ -16,8 +21,57 @@
 /* Page in use. */
 #define PAGE_USED 0x02
 
+/* Page holds a cached executable image.
+ * Reclaimed by memory_allocate if no pages are free. */
+#define PAGE_CACHED 0x03
+
+/* Page is shared between processes. Freed when its
+ * last reference is dropped. */
+#define PAGE_SHARED 0x04
+
+/* Owner of pages allocated by the kernel itself. */
+#define MEMORY_KERNEL 0xff
+
+/* Allocation counters, in pages. Cached images are not
+ * counted, as they are given up whenever a page is needed. */
+typedef struct _MemoryStats_T
+{
+    uint16_t used;
+    uint16_t peak;
+    uint16_t failures;
+} MemoryStats_T;
+
+extern MemoryStats_T memory_stats;
+
 int memory_init(int pages);
 int memory_allocate(void);
+int memory_allocate_for(int pid);
 void memory_free(int page);
+int memory_owner(int page);
+int memory_owned(int pid);
+
+/* Executable image cache.
+ *
+ * Pages that would otherwise be free can hold pristine copies of
+ * recently loaded executables, so that a program can be re-launched
+ * with a bank-to-bank copy instead of reading it from disk again.
+ * Images are keyed by the starting cluster and size of the file.
+ */
+int memory_cache_find(uint16_t cluster, uint32_t size);
+int memory_cache_allocate(uint16_t cluster, uint32_t size);
+void memory_cache_invalidate(uint16_t cluster);
+
+/* Shared pages.
+ *
+ * A shared page is identified by a small ID. Processes must be granted
+ * access to it before they can map it, and each mapping holds a
+ * reference. memory_free drops a reference, and the page is freed
+ * once no references remain.
+ */
+int memory_shared_allocate(int pid);
+int memory_shared_page(int id);
+int memory_shared_grant(int id, int pid, int granter);
+int memory_shared_map(int id, int pid);
+void memory_shared_revoke(int pid);
 
 #endif
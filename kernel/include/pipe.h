@@ -0,0 +1,121 @@
+#ifndef _PIPE_H
+#define _PIPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Pipes.
+ *
+ * A pipe is a ring buffer in kernel RAM connecting the output of one
+ * or more processes to the input of others. Processes are connected
+ * with process_redirect, which counts the readers and writers of each
+ * pipe. A pipe is freed once its last reader and writer are gone.
+ *
+ * A reader that finds the pipe empty, or a writer that finds it full,
+ * is blocked on EVENT_PIPE until the other end makes progress.
+ */
+
+#define PIPES_MAX 4
+
+/* Must be a power of two. */
+#define PIPE_SIZE 128
+
+/* No pipe, i.e. the terminal. */
+#define PIPE_NONE -1
+
+#define E_NOPIPES -1
+
+/* Returned by pipe_read. */
+#define PIPE_EOF -2
+#define PIPE_BLOCKED -3
+
+void pipe_init(void);
+
+/* pipe_create
+ *
+ * Purpose:
+ *     Allocates a pipe, with no readers or writers.
+ * 
+ * Parameters:
+ *     None.
+ * 
+ * Returns:
+ *     ID of the pipe, or E_NOPIPES if none are free.
+ */
+int pipe_create(void);
+
+/* pipe_valid
+ *
+ * Returns true if id refers to an allocated pipe.
+ */
+bool pipe_valid(int id);
+
+/* pipe_attach / pipe_detach
+ *
+ * Purpose:
+ *     Adds or removes a reader or writer of a pipe. Detaching the
+ *     last reader and writer frees the pipe. Both wake any processes
+ *     blocked on the pipe, so that they see the change.
+ * 
+ * Parameters:
+ *     id:    ID of the pipe.
+ *     write: true for a writer, false for a reader.
+ * 
+ * Returns:
+ *     Nothing.
+ */
+void pipe_attach(int id, bool write);
+void pipe_detach(int id, bool write);
+
+/* pipe_write
+ *
+ * Purpose:
+ *     Writes as many of the given bytes as fit in the pipe.
+ *     If not all of them fit, the current process is blocked.
+ *     If the pipe has no readers, the bytes are discarded.
+ * 
+ * Parameters:
+ *     id:    ID of the pipe.
+ *     s:     Bytes to write.
+ *     count: Number of bytes to write.
+ * 
+ * Returns:
+ *     Number of bytes written (or discarded).
+ */
+size_t pipe_write(int id, const char * s, size_t count);
+
+/* pipe_read
+ *
+ * Purpose:
+ *     Reads a byte from the pipe. If it is empty the current
+ *     process is blocked, unless there are no writers left.
+ * 
+ * Parameters:
+ *     id: ID of the pipe.
+ * 
+ * Returns:
+ *     The byte, PIPE_BLOCKED if the pipe is empty, or PIPE_EOF if
+ *     it is empty and has no writers.
+ */
+int pipe_read(int id);
+
+/* pipe_readn
+ *
+ * Purpose:
+ *     Reads as many bytes as are waiting in the pipe, up to max.
+ *     If it is empty the current process is blocked, unless there
+ *     are no writers left.
+ * 
+ * Parameters:
+ *     id:  ID of the pipe.
+ *     buf: Buffer to read into.
+ *     max: Size of the buffer.
+ * 
+ * Returns:
+ *     Number of bytes read, PIPE_BLOCKED if the pipe is empty, or
+ *     PIPE_EOF if it is empty and has no writers.
+ */
+int pipe_readn(int id, char * buf, size_t max);
+
+#endif /* _PIPE_H */
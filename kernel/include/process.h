@@ -7,16 +7,71 @@
 #include <include/terminal.h>
 #include <include/signal.h>
 
+/* Per-process accounting counters.
+ * All counters are 16-bit and wrap on overflow.
+ *
+ * This structure is at the start of ProcessDescriptor_T,
+ * and is updated from assembly - offsets must match the
+ * PSTAT_* definitions in disk.asm.
+ */
+typedef struct _ProcessStats_T
+{
+    uint16_t syscalls;
+    uint16_t ticks;
+    uint16_t sectors_read;
+    uint16_t sectors_written;
+    uint16_t bytes_written;
+} ProcessStats_T;
+
+/* Number of process descriptors. */
+#define PROCS_MAX 16
+
+/* Number of auxiliary banks a process can own,
+ * in addition to the bank it runs in. */
+#define PROCESS_BANKS_MAX 4
+
+/* Unused entry in ProcessDescriptor_T.banks. */
+#define PROCESS_NO_BANK 0xff
+
+/* Bytes addressable in an auxiliary bank. */
+#define PROCESS_BANK_SIZE 0x8000
+
+/* Fields accessed from assembly must not move:
+ * sigstatus is read by the timer handler (PDESC_SIGSTATUS in interrupt.asm).
+ */
 typedef struct _ProcessDescriptor_T
 {
+    ProcessStats_T stats;
     uintptr_t base_address;
     uint8_t bank;
     termstatus_t termstatus;
     sigstatus_t sigstatus;
     sighandlers_t sighandlers;
+    uint8_t banks[PROCESS_BANKS_MAX];
+
+    /* Pipes used in place of the terminal, or PIPE_NONE. */
+    int8_t pipe_in;
+    int8_t pipe_out;
 } ProcessDescriptor_T;
 
 
+/* Information about a process, as returned by the pinfo syscall. */
+typedef struct _ProcessInfo_T
+{
+    int8_t state;
+    uint8_t bank;
+    uintptr_t base_address;
+    ProcessStats_T stats;
+} ProcessInfo_T;
+
+#define E_NOPROCESS -1
+#define E_TOOMANYARGS -2
+#define E_ARGSTOOLONG -3
+#define E_NOBANKS -4
+#define E_NOBANK -5
+#define E_BANKRANGE -6
+#define E_NOPIPE -9
+
 int process_spawn(int pd, char ** argv, size_t argc);
 int process_load(const char * filename);
 void process_init(void);
@@ -28,6 +83,13 @@ void process_init(void);
  */
 ProcessDescriptor_T * process_current(void);
 
+/* process_descriptor
+ *
+ * Returns a pointer to the process descriptor for the
+ * process with given process ID, for the kernel to update.
+ */
+ProcessDescriptor_T * process_descriptor(int pid);
+
 /* process_set_current
  *
  * Sets the current process pointer to that
@@ -42,4 +104,134 @@ void process_set_current(int pid);
  */
 const ProcessDescriptor_T * process_info(int pid);
 
+/* process_get_info
+ *
+ * Copies state and accounting information for the process
+ * with given process ID into the given buffer.
+ * 
+ * Returns 0 on success, or E_NOPROCESS if there is no such process.
+ */
+int process_get_info(int pid, ProcessInfo_T * info);
+
+/* process_redirect
+ *
+ * Connects a loaded process's terminal input and output to pipes,
+ * replacing any previous connection. PIPE_NONE connects the
+ * terminal. Should be called before the process is spawned.
+ * 
+ * Returns 0 on success, E_NOPROCESS if there is no such process,
+ * or E_NOPIPE if either pipe is not allocated.
+ */
+int process_redirect(int pd, int in, int out);
+
+/* process_free
+ *
+ * Releases a process which has been loaded but not spawned,
+ * freeing its bank and descriptor and detaching its pipes.
+ * 
+ * Returns 0 on success, or E_NOPROCESS if there is no such
+ * process or it has already been spawned.
+ */
+int process_free(int pd);
+
+/* process_clone
+ *
+ * Creates a copy of the current process, called from the pclone
+ * syscall. The copy has a new bank holding a copy of the caller's
+ * bank, and the same signal handlers and pipes, but no auxiliary
+ * banks. It is scheduled to continue from the syscall with a
+ * return value of 0.
+ *
+ * Parameters:
+ *     sp: Caller's stack pointer after the syscall returns.
+ *     pc: Syscall's return address.
+ *     ix: Caller's IX register.
+ * 
+ * Returns the process ID of the copy, E_NOPROCESS if no process
+ * descriptor or task is free, or E_NOBANKS if no bank is free.
+ */
+int process_clone(uint16_t sp, uint16_t pc, uint16_t ix);
+
+/* Auxiliary banks.
+ *
+ * A process can own up to PROCESS_BANKS_MAX banks besides the one it
+ * runs in. Only one bank can be selected at a time, and it holds the
+ * process's code and stack, so auxiliary banks are never mapped in.
+ * Instead they are read and written with bank-to-bank copies.
+ * Each is referred to by a handle, and freed when the process exits.
+ */
+
+/* process_bank_alloc
+ *
+ * Allocates an auxiliary bank for the current process.
+ * 
+ * Returns a handle for the bank, or E_NOBANKS if the process already
+ * has PROCESS_BANKS_MAX banks or no bank is free.
+ */
+int process_bank_alloc(void);
+
+/* process_bank_free
+ *
+ * Frees one of the current process's auxiliary banks.
+ * 
+ * Returns 0 on success, or E_NOBANK if the handle is not in use.
+ */
+int process_bank_free(int handle);
+
+/* process_bank_read
+ *
+ * Copies n bytes, starting offset bytes into the auxiliary bank,
+ * into buf in the current process's bank.
+ * 
+ * Returns n on success, E_NOBANK if the handle is not in use or
+ * E_BANKRANGE if either range is out of bounds.
+ */
+int process_bank_read(int handle, uint16_t offset, char * buf, size_t n);
+
+/* process_bank_write
+ *
+ * Copies n bytes from buf in the current process's bank to
+ * offset bytes into the auxiliary bank.
+ * 
+ * Returns as process_bank_read.
+ */
+int process_bank_write(int handle, uint16_t offset, const char * buf, size_t n);
+
+/* Shared banks.
+ *
+ * A shared bank is an auxiliary bank that several processes can map.
+ * Once mapped it is accessed with process_bank_read and
+ * process_bank_write like any other auxiliary bank, and unmapped
+ * with process_bank_free. It is freed when the last process unmaps it.
+ */
+
+/* process_shared_alloc
+ *
+ * Allocates a shared bank and maps it into the current process.
+ * Its ID is written to id, to be passed to other processes.
+ * 
+ * Returns a handle for the bank, or E_NOBANKS if no bank is free
+ * or the process already has PROCESS_BANKS_MAX banks.
+ */
+int process_shared_alloc(uint8_t * id);
+
+/* process_shared_grant
+ *
+ * Allows another process to map a shared bank.
+ * The current process must have access to it.
+ * 
+ * Returns 0 on success, E_NOPROCESS if pid is invalid,
+ * or an error from memory_shared_grant.
+ */
+int process_shared_grant(int id, int pid);
+
+/* process_shared_map
+ *
+ * Maps a shared bank into the current process.
+ * 
+ * Returns a handle for the bank, E_NOBANKS if the process already
+ * has PROCESS_BANKS_MAX banks, or an error from memory_shared_map.
+ */
+int process_shared_map(int id);
+
 #endif
@@ -20,6 +20,9 @@ uint8_t ram_bank_current(void);
  *     Copies data from memory in one bank to memory
  *     in another. After execution, selected bank
  *     will be the same as on entry.
+ *
+ *     Assembly callers can use the register entry point
+ *     __ram_copy instead (see ram.asm).
  * 
  * Parameters:
  *     dst:  Destination pointer
@@ -32,4 +35,23 @@ uint8_t ram_bank_current(void);
  */
 void ram_copy(char * dst, uint8_t bank, char * src, size_t n) STACKCALL;
 
+/* ram_copy_banks
+ *
+ * Purpose:
+ *     Copies data between any two RAM banks, neither of which
+ *     needs to be selected. After execution, selected bank
+ *     will be the same as on entry.
+ * 
+ * Parameters:
+ *     dst:      Destination pointer
+ *     dst_bank: Destination RAM bank
+ *     src:      Source pointer
+ *     src_bank: Source RAM bank
+ *     n:        Size of data to copy
+ * 
+ * Returns:
+ *     Nothing.
+ */
+void ram_copy_banks(char * dst, uint8_t dst_bank, char * src, uint8_t src_bank, size_t n) STACKCALL;
+
 #endif
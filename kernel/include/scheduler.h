@@ -17,6 +17,10 @@ typedef int EventType_T;
 
 #define EVENT_NO_EVENT ((EventType_T)0)
 #define EVENT_PROCESS_FINISHED ((EventType_T)1)
+#define EVENT_TIMER ((EventType_T)2)
+#define EVENT_PIPE ((EventType_T)3)
+#define EVENT_TERMINAL_TX ((EventType_T)4)
+#define EVENT_TERMINAL_RX ((EventType_T)5)
 
 /* scheduler_init
  *
@@ -155,6 +159,33 @@ int scheduler_current_pid(void);
  */
 void scheduler_block(int pid, EventType_T event);
 
+/* scheduler_block_current
+ *
+ * Purpose:
+ *     Blocks the current task on the given event.
+ * 
+ * Parameters:
+ *     Event type
+ * 
+ * Returns:
+ *     Nothing.
+ */
+void scheduler_block_current(EventType_T event);
+
+/* scheduler_broadcast_event
+ *
+ * Purpose:
+ *     Wakes every task blocked on the given event.
+ * 
+ * Parameters:
+ *     event:       Event type.
+ *     exclude_pid: Process ID not to wake, or -1.
+ * 
+ * Returns:
+ *     Nothing.
+ */
+void scheduler_broadcast_event(EventType_T event, int exclude_pid);
+
 /* scheduler_event
  *
  * Purpose:
@@ -168,4 +199,18 @@ void scheduler_block(int pid, EventType_T event);
  */
 EventType_T scheduler_event(int pid);
 
+/* scheduler_sleep
+ *
+ * Purpose:
+ *     Blocks the current task until the given number
+ *     of scheduler ticks have elapsed.
+ * 
+ * Parameters:
+ *     Number of ticks to sleep for.
+ * 
+ * Returns:
+ *     Tick count at which the task will be woken.
+ */
+uint16_t scheduler_sleep(uint16_t ticks);
+
 #endif
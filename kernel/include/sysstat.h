@@ -0,0 +1,85 @@
+#ifndef _SYSSTAT_H
+#define _SYSSTAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Syscall statistics.
+ *
+ * When the kernel is built with SYSCALL_STATS defined, syscalls
+ * enter the kernel through an instrumented copy of the syscall
+ * handler, which counts each syscall and the time spent in it.
+ * The usual handler is left without any of this.
+ *
+ * Time is read from sysstat_clock, which sysstat_init sets to the
+ * kernel tick counter. Ticks only advance during syscalls which run with
+ * interrupts enabled, so for the others only the count is useful,
+ * unless sysstat_clock is pointed at a finer clock.
+ *
+ * A syscall which blocks and is re-issued is counted each time.
+ *
+ * Otherwise nothing is recorded and sysstat_read always returns 0.
+ */
+
+/* One entry per syscall table entry. */
+#define SYSSTAT_MAX 48
+
+typedef struct _SysStat_T
+{
+    uint16_t count;
+    uint16_t time;
+} SysStat_T;
+
+/* Always enabled for unit tests, so the counting is covered. */
+#if defined(UNIT_TEST) && !defined(SYSCALL_STATS)
+#define SYSCALL_STATS
+#endif
+
+extern uint16_t (*sysstat_clock)(void);
+
+/* sysstat_init
+ *
+ * Purpose:
+ *     Clears the statistics, and enters syscalls through the
+ *     instrumented handler.
+ * 
+ * Parameters:
+ *     None.
+ * 
+ * Returns:
+ *     Nothing.
+ */
+void sysstat_init(void);
+
+/* sysstat_enter / sysstat_exit
+ *
+ * Purpose:
+ *     Called by the instrumented handler on entry to and
+ *     return from a syscall.
+ * 
+ * Parameters:
+ *     offset: Offset of the syscall in the syscall table,
+ *             as passed in A.
+ * 
+ * Returns:
+ *     Nothing.
+ */
+void sysstat_enter(uint8_t offset);
+void sysstat_exit(void);
+
+/* sysstat_read
+ *
+ * Purpose:
+ *     Copies the statistics for the first max syscalls,
+ *     indexed by syscall table offset / 2.
+ * 
+ * Parameters:
+ *     buf: Buffer to copy entries into
+ *     max: Maximum number of entries to copy
+ * 
+ * Returns:
+ *     Number of entries copied.
+ */
+size_t sysstat_read(SysStat_T * buf, size_t max);
+
+#endif /* _SYSSTAT_H */
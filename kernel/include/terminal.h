@@ -1,9 +1,12 @@
 #ifndef _TERMINAL_H
 #define _TERMINAL_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <include/iovec.h>
+
 /* Type used for representing a process's terminal status. */
 typedef uint8_t termstatus_t;
 
@@ -16,24 +19,174 @@ typedef uint8_t termstatus_t;
 /* 0 = no data, 1 = data ready */
 #define TERMSTATUS_AVAILABLE (1 << 2)
 
+/* 0 = sread returns -1 if no data, 1 = sread waits for data */
+#define TERMSTATUS_MODE_BLOCKING (1 << 3)
+
+/* Set while the process is waiting in readline, so that
+ * input is edited as it arrives. */
+#define TERMSTATUS_READLINE (1 << 4)
+
+/* 0 = flow control with RTS, 1 = flow control with XON/XOFF in binary mode */
+#define TERMSTATUS_MODE_XONXOFF (1 << 5)
+
+/* Longest line returned by readline, including the terminator. */
+#define TERMINAL_LINE_MAX 128
+
+/* Modes for terminal_set_mode. */
+#define TERMINAL_MODE_BINARY 0x01
+#define TERMINAL_MODE_BLOCKING 0x02
+#define TERMINAL_MODE_XONXOFF 0x04
+
+/* Receive counters. All wrap on overflow.
+ *
+ * overruns is updated from assembly - its offset must
+ * match TSTAT_OVERRUNS in interrupt.asm.
+ */
+typedef struct _TerminalStats_T
+{
+    /* Bytes dropped because the terminal's buffer was full. */
+    uint16_t dropped;
+
+    /* Bytes lost because the #6850 received another
+     * before the receive interrupt could read it. */
+    uint16_t overruns;
+
+    /* Number of times the sender was asked to stop. */
+    uint16_t throttled;
+} TerminalStats_T;
+
+extern TerminalStats_T terminal_stats;
+
+/* Returned by terminal_get if the process has been blocked
+ * waiting for input. Same as PIPE_BLOCKED. */
+#define TERMINAL_BLOCKED -3
+
+/* No process has the active terminal. */
+#define TERMINAL_NONE -1
+
+/* Returned by terminal_set_active, so distinct
+ * from the process error codes. */
+#define E_NOTERMINAL -10
+
 void terminal_init(void);
 
+/* terminal_set_active
+ *
+ * Makes the terminal of the process with given ID the active
+ * terminal, so that it receives input and signals from the serial
+ * port. When that process exits, the active terminal goes back to
+ * the process which had it before, if it is still running.
+ *
+ * Returns the ID of the process which had the active terminal,
+ * TERMINAL_NONE if there was none, or E_NOTERMINAL if there is
+ * no such process.
+ */
+int terminal_set_active(int pid);
+
+/* terminal_active_pid
+ *
+ * Returns the ID of the process with the active terminal,
+ * or TERMINAL_NONE.
+ */
+int terminal_active_pid(void);
+
+/* terminal_exit
+ *
+ * Discards the input of an exiting process, and hands
+ * on the active terminal if it has it.
+ */
+void terminal_exit(int pid);
+
 /* terminal_set_mode
  *
- * Sets the terminal mode based on parameter:
+ * Sets the terminal mode based on parameter bits:
  * 
- * Zero      - set mode to interactive
- * Non-zero  - set mode to binary
+ * TERMINAL_MODE_BINARY   - clear for interactive, set for binary
+ * TERMINAL_MODE_BLOCKING - set to wait for input in terminal_get
+ * TERMINAL_MODE_XONXOFF  - set to use XON/XOFF rather than RTS
+ *                          for flow control in binary mode
  */
 void terminal_set_mode(int mode);
 
+/* terminal_write
+ *
+ * Writes count bytes from s to the terminal, or to the
+ * process's output pipe. Returns the number of bytes written,
+ * which is less than count if the pipe or the transmit buffer
+ * filled up, in which case the process has been blocked.
+ *
+ * Bytes for the terminal are queued in a transmit buffer,
+ * and sent from the transmit interrupt.
+ */
+size_t terminal_write(const char * s, size_t count);
+
+/* terminal_writev
+ *
+ * Writes each of count pieces of iov in turn, as terminal_write.
+ * Returns the number of pieces written. If that is less than count,
+ * the process has been blocked, and the piece it stopped in has
+ * been moved on past the bytes that were written.
+ */
+size_t terminal_writev(IOVec_T * iov, size_t count);
+
+/* terminal_tx_next
+ *
+ * Called from the transmit interrupt. Returns the next byte to
+ * transmit, or -1 if there is none, in which case the transmit
+ * interrupt has been disabled.
+ */
+int terminal_tx_next(void);
+
 void terminal_put(char c);
 
 /* terminal_get
  *
- * Returns byte from terminal, or -1
- * if no byte available.
+ * Returns byte from the current process's terminal, or -1
+ * if no byte available. Only the active terminal receives
+ * bytes, but a process can read what it received while it
+ * was active.
+ *
+ * In blocking mode, blocks the process on EVENT_TERMINAL_RX
+ * and returns TERMINAL_BLOCKED if no byte is available.
+ *
+ * If the process's input is a pipe, returns a byte from
+ * the pipe, PIPE_EOF, or PIPE_BLOCKED (see pipe.h).
  */
 int terminal_get(void);
 
+/* terminal_readn
+ *
+ * Copies up to max bytes from the current process's terminal into
+ * buf in one go. If fewer than min bytes are waiting, blocks the
+ * process on EVENT_TERMINAL_RX until there are, and returns
+ * TERMINAL_BLOCKED. min is limited to the point at which the sender
+ * is asked to stop, and with min 0 the read never blocks.
+ *
+ * If the process's input is a pipe, min is ignored, and the read
+ * only blocks if the pipe is empty (see pipe_readn).
+ *
+ * Returns the number of bytes read, or TERMINAL_BLOCKED.
+ */
+int terminal_readn(char * buf, size_t max, size_t min);
+
+/* terminal_readline
+ *
+ * Reads a line from the current process's terminal into buf,
+ * without the line ending, and terminates it. Lines longer than
+ * max - 1 bytes are truncated.
+ *
+ * In interactive mode the line is echoed and can be edited with
+ * backspace as it is typed, in the receive interrupt. In binary
+ * mode it is read raw, up to a carriage return or line feed.
+ *
+ * If the process's input is a pipe, the line is read from the
+ * pipe, raw, up to a carriage return or line feed.
+ *
+ * Returns the length of the line, or TERMINAL_BLOCKED if the
+ * line is not finished, or the process does not have the active
+ * terminal, in which case the process has been blocked. Returns
+ * PIPE_EOF once the input pipe is empty and has no writers.
+ */
+int terminal_readline(char * buf, size_t max);
+
 #endif
@@ -0,0 +1,93 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Scheduler trace.
+ *
+ * When the kernel is built with SCHED_TRACE defined, scheduler
+ * activity is recorded in a ring buffer in kernel RAM. Once the
+ * buffer is full the oldest entries are overwritten.
+ *
+ * Otherwise no trace is recorded and trace_drain always returns 0.
+ */
+
+typedef uint8_t TraceReason_T;
+
+/* Scheduler switched from one task to another.
+ * from and to are both process IDs. */
+#define TRACE_SWITCH ((TraceReason_T)0)
+
+/* Task blocked on an event.
+ * from is the process ID, to is the event type. */
+#define TRACE_BLOCK  ((TraceReason_T)1)
+
+/* Task was woken by an event.
+ * from is the process ID, to is the event type. */
+#define TRACE_WAKE   ((TraceReason_T)2)
+
+typedef struct _TraceEntry_T
+{
+    uint16_t tick;
+    int8_t from;
+    int8_t to;
+    TraceReason_T reason;
+} TraceEntry_T;
+
+/* Always enabled for unit tests, so the buffer logic is covered. */
+#if defined(UNIT_TEST) && !defined(SCHED_TRACE)
+#define SCHED_TRACE
+#endif
+
+#ifdef SCHED_TRACE
+#define TRACE(_reason, _from, _to) trace_record(_reason, _from, _to)
+#else
+#define TRACE(_reason, _from, _to)
+#endif
+
+/* trace_init
+ *
+ * Purpose:
+ *     Empties the trace buffer.
+ * 
+ * Parameters:
+ *     None.
+ * 
+ * Returns:
+ *     Nothing.
+ */
+void trace_init(void);
+
+/* trace_record
+ *
+ * Purpose:
+ *     Records a scheduler event in the trace buffer,
+ *     stamped with the current tick.
+ * 
+ * Parameters:
+ *     reason: Type of event
+ *     from:   Process ID
+ *     to:     Process ID or event type, depending on reason
+ * 
+ * Returns:
+ *     Nothing.
+ */
+void trace_record(TraceReason_T reason, int8_t from, int8_t to);
+
+/* trace_drain
+ *
+ * Purpose:
+ *     Copies the oldest entries out of the trace buffer,
+ *     removing them from the buffer.
+ * 
+ * Parameters:
+ *     buf: Buffer to copy entries into
+ *     max: Maximum number of entries to copy
+ * 
+ * Returns:
+ *     Number of entries copied.
+ */
+size_t trace_drain(TraceEntry_T * buf, size_t max);
+
+#endif /* _TRACE_H */
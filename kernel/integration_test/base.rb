@@ -8,6 +8,7 @@ require_relative '../../../zemu/lib/zemu'
 require_relative '../../../z80-libraries/vars.rb'
 
 require_relative '../../zemu/config'
+require_relative '../../zemu/trace'
 
 class IntegrationTest < Minitest::Test
     def log(message)
@@ -247,17 +248,19 @@ class IntegrationTest < Minitest::Test
 
         s = []
         16.times do |i|
-            base = addr + (i * 7)
+            base = addr + (i * 10)
             state = get_int8(base)
             event = get_int16(base+1)
             pid = get_int16(base+3)
             exitcode = get_int16(base+5)
+            sleep_delta = get_int16(base+7)
 
             s << "SCHEDULE TABLE #{i}"
             s << "    STATE: %d" % state
             s << "    EVENT: %d" % event
             s << "    PID:   %d" % pid
             s << "    EXIT:  %d" % exitcode
+            s << "    SLEEP: %d" % sleep_delta
         end
         s.join("\n")
     end
@@ -293,6 +296,12 @@ class IntegrationTest < Minitest::Test
         msg += "\nSTATE:\n"
         msg += "Stack:\n#{stack_string()}\n"
         msg += schedule_table()
+
+        if scheduler_trace_enabled?("kernel_debug.map")
+            msg += "\nScheduler trace:\n"
+            msg += scheduler_timeline(scheduler_trace(@instance))
+            msg += "\n"
+        end
         msg += "\nTrace:\n"
 
         count = 0
@@ -0,0 +1,30 @@
+#include <syscall.h>
+#include <string.h>
+#include <stdio.h>
+
+const char file[21] =
+{
+    0x0c, 0x80, /* header - version 2 executable file at base addr 0x8000 */
+    0x02, 0x80, /* entry point 0x8002 */
+    0x05, 0x00, /* code size */
+    0x00, 0xd0, /* data address 0xd000 */
+    0x02, 0x00, /* data size */
+    0x02, 0xd0, /* bss address 0xd002 */
+    0x04, 0x00, /* bss size */
+    0xa5, 0xb6, 0xc7, 0xd8, 0xe9, /* code */
+    0x11, 0x22 /* data */
+};
+
+int main(void)
+{
+    /* Write file */
+    int fd = syscall_fopen("testprog.exe", FMODE_WRITE);
+    syscall_fwrite(file, 21, fd);
+    syscall_fclose(fd);
+
+    int pd = syscall_pload("testprog.exe");
+
+    if (pd != 1) return 1;
+
+    return 0;
+}
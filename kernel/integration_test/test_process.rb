@@ -132,6 +132,28 @@ class ProcessTest < IntegrationTest
         assert_equal 0xe9, @instance.device("banked_ram").contents(1)[0x0004]
     end
 
+    def test_pload_v2
+        # Then continue until halt.
+        # By this point the code should have been loaded at 0x8000
+        # and the data at 0xd000.
+        @instance.continue 1000000
+        assert @instance.halted?, "Program did not halt (at address %04x)" % @instance.registers["PC"]
+        assert_equal 0x0000, @instance.registers["HL"]
+
+        bank = @instance.device("banked_ram").contents(1)
+
+        # Assert contents of memory.
+        assert_equal [0xa5, 0xb6, 0xc7, 0xd8, 0xe9], (0...5).map { |i| bank[0x0000 + i] }
+        assert_equal [0x11, 0x22], (0...2).map { |i| bank[0x5000 + i] }
+
+        # BSS is zeroed.
+        assert_equal [0x00] * 4, (0...4).map { |i| bank[0x5002 + i] }
+
+        # Entry point from the header is on the initial stack.
+        assert_equal 0x02, bank[0x77f8]
+        assert_equal 0x80, bank[0x77f9]
+    end
+
     def test_pload_large
         # Then continue until halt.
         # By this point the file should have been loaded at 0x8000.
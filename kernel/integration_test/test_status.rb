@@ -68,7 +68,7 @@ class StatusTest < IntegrationTest
         prog_symbols = load_test_map()
         kernel_symbols = load_kernel_map()
 
-        int_breakpoint = kernel_symbols.find_by_name("_driver_6850_tx")
+        int_breakpoint = kernel_symbols.find_by_name("_terminal_write")
         assert !int_breakpoint.nil?, "Could not find symbol for swrite handler!"
 
         prog_breakpoint = prog_symbols.find_by_name("_test_func")
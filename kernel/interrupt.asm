@@ -14,12 +14,6 @@ _interrupt_handler:
     exx
     ex      AF, AF'
 
-    call    _status_set_int
-
-    ; Get return address (TOS) into HL.
-    pop     HL
-    push    HL ; Don't forget to restore it!
-
     ; Is this an interrupt from the #6850?
     in      A, (UART_PORT_CONTROL)
     bit     #7, A
@@ -27,24 +21,36 @@ _interrupt_handler:
     
     ; Character received?
     bit     #0, A
-    jp      nz, #__serial_read_handler
+    jp      nz, #__interrupt_serial_read
+
+    ; Ready to transmit?
+    bit     #1, A
+    jp      z, #__interrupt_skip2
+
+    call    _status_set_int
+    jp      __serial_write_handler
+
+__interrupt_serial_read:
+    call    _status_set_int
+    jp      __serial_read_handler
 
     ; Not a #6850 interrupt.
 __interrupt_skip2:
     ; Is this a timer interrupt?
+    ; The INT status is not set for timer interrupts,
+    ; to keep the scheduler tick as cheap as possible.
     in      A, (TIMER_CONTROL)
     cp      #1
-    jp      nz, #__interrupt_skip3
+    jp      z, #__timer_handler
 
-    jp      __timer_handler
-
-__interrupt_skip3:
     ; Not any of the known causes.
+    call    _status_set_int
     jp      __unknown_interrupt
 
 __interrupt_handle_ret:
     call    _status_clr_int
-    
+
+__interrupt_exit:
     ex      AF, AF'
     exx
     ei
@@ -62,29 +68,128 @@ __interrupt_handler_end:
     ; TODO: Find a way around this.
     .globl  __serial_read_handler
 
+    .globl  _terminal_stats
+
+    ; Offset of overruns in TerminalStats_T.
+    .equ    TSTAT_OVERRUNS, 2
+
 __serial_read_handler:
+    ; A still holds the #6850's status.
+    ; Was a byte lost before this one?
+    bit     #5, A
+    jp      z, __serial_read_data
+
+    ld      HL, (_terminal_stats + TSTAT_OVERRUNS)
+    inc     HL
+    ld      (_terminal_stats + TSTAT_OVERRUNS), HL
+
+__serial_read_data:
     ; Read data from UART and send to terminal.
     in      A, (UART_PORT_DATA)
     call    _terminal_put
     
     jp      __interrupt_handle_ret
 
+    .globl  _terminal_tx_next
+
+    ; Sends the next byte from the terminal's transmit buffer.
+    ; The transmit interrupt is only enabled while there is
+    ; something to send, and terminal_tx_next disables it
+    ; once the buffer is empty.
+__serial_write_handler:
+    call    _terminal_tx_next
+
+    ; -1 if nothing to send.
+    bit     #7, D
+    jp      nz, __interrupt_handle_ret
+
+    ld      A, E
+    out     (UART_PORT_DATA), A
+
+    jp      __interrupt_handle_ret
+
 
 
     .globl  _scheduler_tick
     .globl  _ram_bank_set
     .globl  _signal_get_handler
     .globl  _status_is_set_kernel
+    .globl  _scheduler_ticks
+    .globl  _bank_current
+    .globl  _process_current_ptr
+
+    ; Offset of sigstatus in ProcessDescriptor_T.
+    ; Must match include/process.h.
+    .equ    PDESC_SIGSTATUS, 14
 
     ; These two symbols need to be global for benchmarking.
     .globl  __timer_handler
     .globl  __timer_handler_end
 __timer_handler:
+    ; Count every tick, even if we skip the scheduler below,
+    ; so that sleeping tasks are woken on time.
+    ld      HL, (_scheduler_ticks)
+    inc     HL
+    ld      (_scheduler_ticks), HL
+
     ; Skip timer handler if we are currently executing in kernel space.
     call    _status_is_set_kernel
-    cp      #0
+    or      A
     jp      nz, __timer_handler_end
 
+    ; Entry point for a context switch. Also entered from the pyield
+    ; syscall, with the same stack and register state as an interrupt.
+    ;
+    ; The process's registers are in the alternate register set,
+    ; apart from IX and IY. They are only stacked if the scheduler
+    ; picks a different task, or a signal needs to be handled.
+    .globl  __timer_handler_switch
+__timer_handler_switch:
+    ; Run the scheduler on the kernel stack.
+    ld      (__timer_sp), SP
+    ld      SP, #0x7ffe
+    push    IX
+    push    IY
+
+    ; Call the scheduler to allocate another process.
+    ; New RAM bank is returned in A.
+    ; Each process has its own bank, so if the bank is unchanged
+    ; then the current process has been scheduled again.
+    call    _scheduler_tick
+    ld      HL, #_bank_current
+    cp      (HL)
+    jp      nz, #__timer_handler_save
+
+    ; Fast path: same process continues.
+    ; Check if there are any signals pending for it.
+    pop     IY
+    pop     IX
+    ld      HL, (_process_current_ptr)
+    ld      DE, #PDESC_SIGSTATUS
+    add     HL, DE
+    ld      A, (HL)
+    or      A
+    jp      nz, #__timer_handler_save_signal
+
+    ld      SP, (__timer_sp)
+    jp      __timer_handler_end
+
+    ; The current process has a signal pending. Stack its registers
+    ; so that the signal handler can be entered as below.
+__timer_handler_save_signal:
+    ld      SP, (__timer_sp)
+    ld      A, (_bank_current)
+    ld      (__timer_bank), A
+    jp      __timer_handler_stack
+
+    ; Switching to another process.
+__timer_handler_save:
+    ld      (__timer_bank), A
+    pop     IY
+    pop     IX
+    ld      SP, (__timer_sp)
+
+__timer_handler_stack:
     ; Switch to user register set and stack all registers.
     exx
     ex      AF, AF'
@@ -97,12 +202,10 @@ __timer_handler:
 
     ld      (0xfffe), SP
 
-    ; Set stack to kernel space.
+    ; Set stack to kernel space, and switch to the bank
+    ; of the new process.
     ld      SP, #0x7ffe
-
-    ; Call the scheduler to allocate another process.
-    ; New RAM bank is returned in A.
-    call    _scheduler_tick
+    ld      A, (__timer_bank)
     call    _ram_bank_set
 
     ; Check if there are any signals to handle for the
@@ -169,8 +272,14 @@ __timer_handler_ret_to_process:
     exx
 
     ; Return from the interrupt.
+    ; The INT status was not set for the timer, so skip clearing it.
 __timer_handler_end:
-    jp      __interrupt_handle_ret
+    jp      __interrupt_exit
+
+__timer_sp:
+    .word   0
+__timer_bank:
+    .byte   0
 
 __unknown_interrupt:
     jp      __interrupt_handle_ret
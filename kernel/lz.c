@@ -0,0 +1,125 @@
+#include <string.h>
+
+#include <include/file.h>
+#include <include/lz.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_EXTENDED 15
+
+/* Read a sector at a time, so that file_read can read whole
+ * sectors straight into the buffer rather than byte by byte. */
+#define LZ_IN_SIZE 512
+
+extern FileDescriptor_T fdtable[FILE_LIMIT];
+
+/* The decoder runs with the target bank selected, so its state
+ * has to be in kernel RAM. */
+char lz_in[LZ_IN_SIZE];
+uint16_t lz_in_pos;
+uint16_t lz_in_len;
+int lz_fd;
+uint8_t lz_eof;
+
+void lz_begin(int fd)
+{
+    lz_fd = fd;
+    lz_in_pos = 0;
+    lz_in_len = 0;
+    lz_eof = 0;
+}
+
+/* Refill the input buffer up to the end of the current sector,
+ * so that later refills start on a sector boundary.
+ * Sets lz_eof at the end of the file. */
+static void lz_fill(void)
+{
+    lz_in_len = (uint16_t)file_read(lz_in, LZ_IN_SIZE - fdtable[lz_fd].fpos_within_sector, lz_fd);
+    lz_in_pos = 0;
+
+    if (lz_in_len == 0) lz_eof = 1;
+}
+
+static uint8_t lz_next(void)
+{
+    if (lz_in_pos == lz_in_len)
+    {
+        lz_fill();
+        if (lz_eof) return 0;
+    }
+
+    return (uint8_t)lz_in[lz_in_pos++];
+}
+
+/* Adds extension bytes to a length nibble of 15. */
+static uint16_t lz_length(uint16_t n)
+{
+    if (n != LZ_EXTENDED) return n;
+
+    uint8_t b;
+    do
+    {
+        b = lz_next();
+        n += b;
+    }
+    while (b == 0xff && !lz_eof);
+
+    return n;
+}
+
+int lz_decode(char * dst, uint16_t size)
+{
+    char * out = dst;
+
+    while (size)
+    {
+        uint8_t token = lz_next();
+
+        /* Literals, copied from the input buffer a chunk at a time. */
+        uint16_t n = lz_length(token >> 4);
+        if (n > size) return E_LZCORRUPT;
+        size -= n;
+
+        while (n)
+        {
+            if (lz_in_pos == lz_in_len) lz_fill();
+            if (lz_eof) return E_LZCORRUPT;
+
+            uint16_t chunk = lz_in_len - lz_in_pos;
+            if (chunk > n) chunk = n;
+
+            memcpy(out, &lz_in[lz_in_pos], chunk);
+            out += chunk;
+            lz_in_pos += chunk;
+            n -= chunk;
+        }
+
+        if (size == 0) break;
+
+        /* Match. */
+        uint16_t offset = lz_next();
+        offset |= (uint16_t)lz_next() << 8;
+
+        n = lz_length(token & 0x0f) + LZ_MIN_MATCH;
+
+        if (lz_eof) return E_LZCORRUPT;
+        if (offset == 0 || offset > (uint16_t)(out - dst)) return E_LZCORRUPT;
+        if (n > size) return E_LZCORRUPT;
+        size -= n;
+
+        const char * from = out - offset;
+
+        if (offset >= n)
+        {
+            /* No overlap, so a block copy will do. */
+            memcpy(out, from, n);
+            out += n;
+        }
+        else
+        {
+            /* Overlapping match repeats the last offset bytes. */
+            while (n--) *out++ = *from++;
+        }
+    }
+
+    return 0;
+}
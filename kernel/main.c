@@ -25,6 +25,8 @@
 #include <include/process.h>
 #include <include/memory.h>
 #include <include/scheduler.h>
+#include <include/pipe.h>
+#include <include/sysstat.h>
 
 extern SysInfo_T sysinfo;
 
@@ -47,6 +49,10 @@ void main(void)
     status_init();
     status_set_kernel();
 
+    /* Disk reads are counted against the current process,
+     * so the process table has to be set up first. */
+    process_init();
+
     disk_init();
     filesystem_init();
 
@@ -61,12 +67,14 @@ void main(void)
         printf("Memory initialization error: %d\r\n", e);
     }
 
-    process_init();
-
     scheduler_init();
 
     terminal_init();
 
+    pipe_init();
+
+    sysstat_init();
+
 #ifndef DEBUG
     //printf("Z80-OS KERNEL v%s\r\n", &kernel_version);
     //printf("Memory: %d banks\r\n", (int)sysinfo.numbanks);
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include <include/memory.h>
 
 #define PAGES_MAX 256
@@ -6,8 +8,93 @@
 int num_pages;
 uint8_t page_table[PAGES_MAX];
 
+/* Process which allocated each page, or MEMORY_KERNEL. */
+uint8_t page_owner[PAGES_MAX];
+
+/* Bit n set if page n is free, so that a free page
+ * can be found a byte at a time. */
+uint8_t page_free_map[PAGES_MAX / 8];
+
+MemoryStats_T memory_stats;
+
+#define CACHE_ENTRIES 8
+
+/* Cluster 0 is never the start of a file. */
+#define CACHE_EMPTY 0
+
+typedef struct _CacheEntry_T
+{
+    uint16_t cluster;
+    uint32_t size;
+    uint8_t page;
+
+    /* Value of cache_clock when last used. */
+    uint16_t used;
+} CacheEntry_T;
+
+CacheEntry_T cache_table[CACHE_ENTRIES];
+uint16_t cache_clock;
+
+#define SHARED_MAX 8
+
+typedef struct _SharedEntry_T
+{
+    uint8_t page;
+
+    /* Number of mappings. Zero if the entry is unused. */
+    uint8_t refs;
+
+    /* Bit n set if process n may map the page. */
+    uint16_t granted;
+} SharedEntry_T;
+
+SharedEntry_T shared_table[SHARED_MAX];
+
 /* Routines for memory management. */
 
+static void memory_mark_free(int page)
+{
+    page_table[page] = PAGE_FREE;
+    page_owner[page] = MEMORY_KERNEL;
+    page_free_map[page >> 3] |= (uint8_t)(1 << (page & 7));
+}
+
+/* Takes a page off the free map, and accounts
+ * for it if it is being allocated to someone. */
+static void memory_take(int page, uint8_t type, uint8_t owner)
+{
+    page_table[page] = type;
+    page_owner[page] = owner;
+    page_free_map[page >> 3] &= (uint8_t)~(1 << (page & 7));
+
+    if (type == PAGE_USED)
+    {
+        memory_stats.used++;
+        if (memory_stats.used > memory_stats.peak) memory_stats.peak = memory_stats.used;
+    }
+}
+
+/* Returns the lowest numbered free page, or -1 if none are free. */
+static int memory_first_free(void)
+{
+    for (int i = 0; i < (num_pages + 7) >> 3; i++)
+    {
+        uint8_t bits = page_free_map[i];
+        if (bits == 0) continue;
+
+        int page = i << 3;
+        while (!(bits & 1))
+        {
+            bits >>= 1;
+            page++;
+        }
+
+        return page;
+    }
+
+    return -1;
+}
+
 /* Initializes the memory manager.
  *
  * Parameters:
@@ -22,10 +109,17 @@ int memory_init(int pages)
 
     num_pages = pages;
 
+    memset(page_free_map, 0, sizeof(page_free_map));
+    memset(page_owner, MEMORY_KERNEL, sizeof(page_owner));
+
+    memory_stats.used = 0;
+    memory_stats.peak = 0;
+    memory_stats.failures = 0;
+
     /* Mark all available pages as free. */
     for (int i = 0; i < pages; i++)
     {
-        page_table[i] = PAGE_FREE;
+        memory_mark_free(i);
     }
 
     /* Mark all the rest as disabled. */
@@ -35,14 +129,56 @@ int memory_init(int pages)
     }
 
 #ifdef DEBUG
-    page_table[0] = PAGE_USED;
+    memory_take(0, PAGE_USED, MEMORY_KERNEL);
 #endif
 
+    for (int i = 0; i < CACHE_ENTRIES; i++)
+    {
+        cache_table[i].cluster = CACHE_EMPTY;
+    }
+
+    cache_clock = 0;
+
+    for (int i = 0; i < SHARED_MAX; i++)
+    {
+        shared_table[i].refs = 0;
+    }
+
     return 0;
 }
 
+/* Returns the least recently used cache entry, or -1 if the cache is empty. */
+static int memory_cache_lru(void)
+{
+    int lru = -1;
+
+    for (int i = 0; i < CACHE_ENTRIES; i++)
+    {
+        if (cache_table[i].cluster == CACHE_EMPTY) continue;
+
+        /* Compare ages rather than stamps so that the clock can wrap. */
+        if (lru < 0 || (uint16_t)(cache_clock - cache_table[i].used) > (uint16_t)(cache_clock - cache_table[lru].used))
+        {
+            lru = i;
+        }
+    }
+
+    return lru;
+}
+
+/* Drops a cache entry, returning its page. */
+static int memory_cache_evict(int entry)
+{
+    int page = cache_table[entry].page;
+
+    cache_table[entry].cluster = CACHE_EMPTY;
+    memory_mark_free(page);
+
+    return page;
+}
 
-/* Allocates a page of memory.
+
+/* Allocates a page of memory to the kernel.
  *
  * Paramters:
  *     None.
@@ -53,19 +189,38 @@ int memory_init(int pages)
  */
 int memory_allocate(void)
 {
-    for (int i = 0; i < num_pages; i++)
+    return memory_allocate_for(MEMORY_KERNEL);
+}
+
+/* Allocates a page of memory to a process.
+ *
+ * Paramters:
+ *     pid: Process to record as the owner of the page.
+ * 
+ * Returns:
+ *     Index in page table of the next free
+ *     page, or <0 if error.
+ */
+int memory_allocate_for(int pid)
+{
+    int page = memory_first_free();
+
+    /* Reclaim the least recently used cached image. */
+    if (page < 0)
     {
-        /* If we've found a free page, mark it as used
-         * and return the index. */
-        if (page_table[i] == PAGE_FREE)
-        {
-            page_table[i] = PAGE_USED;
-            return i;
-        }
+        int lru = memory_cache_lru();
+        if (lru >= 0) page = memory_cache_evict(lru);
     }
 
     /* No free pages, return error. */
-    return E_NOPAGES;
+    if (page < 0)
+    {
+        memory_stats.failures++;
+        return E_NOPAGES;
+    }
+
+    memory_take(page, PAGE_USED, (uint8_t)pid);
+    return page;
 }
 
 /* Frees a page.
@@ -75,6 +230,253 @@ int memory_allocate(void)
  */
 void memory_free(int page)
 {
+    /* Shared pages are only freed with their last reference. */
+    if (page_table[page] == PAGE_SHARED)
+    {
+        for (int i = 0; i < SHARED_MAX; i++)
+        {
+            if (shared_table[i].refs == 0 || shared_table[i].page != page) continue;
+
+            if (--shared_table[i].refs != 0) return;
+        }
+    }
+    else if (page_table[page] != PAGE_USED) return;
+
     /* Free the page. */
-    page_table[page] = PAGE_FREE;
+    memory_stats.used--;
+    memory_mark_free(page);
+}
+
+/* Gets the owner of a page.
+ *
+ * Parameters:
+ *     page: Page to look up.
+ * 
+ * Returns:
+ *     ID of the process which allocated the page, or MEMORY_KERNEL
+ *     if it is free or was allocated by the kernel.
+ */
+int memory_owner(int page)
+{
+    return page_owner[page];
+}
+
+/* Counts the pages held by a process, e.g. to check for leaks
+ * once it has exited.
+ *
+ * Parameters:
+ *     pid: ID of the process.
+ * 
+ * Returns:
+ *     Number of pages allocated to the process and not yet freed.
+ */
+int memory_owned(int pid)
+{
+    int n = 0;
+
+    for (int i = 0; i < num_pages; i++)
+    {
+        if (page_owner[i] == pid && page_table[i] != PAGE_FREE) n++;
+    }
+
+    return n;
+}
+
+/* Looks up a cached image, and marks it as recently used.
+ *
+ * Parameters:
+ *     cluster: Starting cluster of the executable file.
+ *     size:    Size of the executable file in bytes.
+ * 
+ * Returns:
+ *     Page holding the image, or E_NOPAGES if it is not cached.
+ */
+int memory_cache_find(uint16_t cluster, uint32_t size)
+{
+    for (int i = 0; i < CACHE_ENTRIES; i++)
+    {
+        if (cache_table[i].cluster == cluster && cache_table[i].size == size && cluster != CACHE_EMPTY)
+        {
+            cache_table[i].used = ++cache_clock;
+            return cache_table[i].page;
+        }
+    }
+
+    return E_NOPAGES;
+}
+
+/* Allocates a page to cache an image in. Uses a free page if
+ * there is one, otherwise replaces the least recently used image.
+ * The caller copies the image into the page.
+ *
+ * Parameters:
+ *     cluster: Starting cluster of the executable file.
+ *     size:    Size of the executable file in bytes.
+ * 
+ * Returns:
+ *     Page to copy the image to, or E_NOPAGES if none is available.
+ */
+int memory_cache_allocate(uint16_t cluster, uint32_t size)
+{
+    if (cluster == CACHE_EMPTY) return E_NOPAGES;
+
+    /* Replace any stale image of the same file. */
+    memory_cache_invalidate(cluster);
+
+    /* Find an entry, replacing the least recently used if all are taken. */
+    int entry = -1;
+    for (int i = 0; i < CACHE_ENTRIES; i++)
+    {
+        if (cache_table[i].cluster == CACHE_EMPTY)
+        {
+            entry = i;
+            break;
+        }
+    }
+
+    if (entry < 0)
+    {
+        entry = memory_cache_lru();
+        memory_cache_evict(entry);
+    }
+
+    /* Only pages nobody else wants are used for the cache. */
+    int page = memory_first_free();
+
+    /* Otherwise reuse the page of the least recently used image. */
+    if (page < 0)
+    {
+        int lru = memory_cache_lru();
+        if (lru < 0) return E_NOPAGES;
+
+        page = memory_cache_evict(lru);
+    }
+
+    memory_take(page, PAGE_CACHED, MEMORY_KERNEL);
+
+    cache_table[entry].cluster = cluster;
+    cache_table[entry].size = size;
+    cache_table[entry].page = (uint8_t)page;
+    cache_table[entry].used = ++cache_clock;
+
+    return page;
+}
+
+/* Drops any cached image of the file starting at the given
+ * cluster, e.g. because the file has been deleted.
+ *
+ * Parameters:
+ *     cluster: Starting cluster of the file.
+ */
+void memory_cache_invalidate(uint16_t cluster)
+{
+    for (int i = 0; i < CACHE_ENTRIES; i++)
+    {
+        if (cache_table[i].cluster == cluster && cluster != CACHE_EMPTY)
+        {
+            memory_cache_evict(i);
+        }
+    }
+}
+
+/* Allocates a shared page, mapped by the given process.
+ *
+ * Parameters:
+ *     pid: Process creating the page. It is granted
+ *          access and holds the first reference.
+ * 
+ * Returns:
+ *     ID of the shared page, or E_NOPAGES if no page
+ *     or shared page ID is available.
+ */
+int memory_shared_allocate(int pid)
+{
+    for (int i = 0; i < SHARED_MAX; i++)
+    {
+        if (shared_table[i].refs != 0) continue;
+
+        int page = memory_allocate_for(pid);
+        if (page < 0) return page;
+
+        page_table[page] = PAGE_SHARED;
+
+        shared_table[i].page = (uint8_t)page;
+        shared_table[i].refs = 1;
+        shared_table[i].granted = (uint16_t)1 << pid;
+
+        return i;
+    }
+
+    return E_NOPAGES;
+}
+
+/* Grants a process access to a shared page.
+ *
+ * Parameters:
+ *     id:      ID of the shared page.
+ *     pid:     Process to grant access to.
+ *     granter: Process granting access, which must
+ *              have access itself.
+ * 
+ * Returns:
+ *     0 if successful, E_NOSHARED if there is no such shared
+ *     page or E_NOTGRANTED if the granter does not have access.
+ */
+int memory_shared_grant(int id, int pid, int granter)
+{
+    if (id < 0 || id >= SHARED_MAX || shared_table[id].refs == 0) return E_NOSHARED;
+    if (!(shared_table[id].granted & ((uint16_t)1 << granter))) return E_NOTGRANTED;
+
+    shared_table[id].granted |= (uint16_t)1 << pid;
+    return 0;
+}
+
+/* Gets the page for a shared page ID, without taking a reference.
+ *
+ * Parameters:
+ *     id: ID of the shared page.
+ * 
+ * Returns:
+ *     The page, or E_NOSHARED if there is no such shared page.
+ */
+int memory_shared_page(int id)
+{
+    if (id < 0 || id >= SHARED_MAX || shared_table[id].refs == 0) return E_NOSHARED;
+
+    return shared_table[id].page;
+}
+
+/* Takes a reference to a shared page, for a new mapping.
+ * Drop it with memory_free.
+ *
+ * Parameters:
+ *     id:  ID of the shared page.
+ *     pid: Process mapping the page.
+ * 
+ * Returns:
+ *     The page, E_NOSHARED if there is no such shared page or
+ *     E_NOTGRANTED if the process has not been granted access.
+ */
+int memory_shared_map(int id, int pid)
+{
+    if (id < 0 || id >= SHARED_MAX || shared_table[id].refs == 0) return E_NOSHARED;
+    if (!(shared_table[id].granted & ((uint16_t)1 << pid))) return E_NOTGRANTED;
+
+    shared_table[id].refs++;
+    return shared_table[id].page;
+}
+
+/* Withdraws a process's access to every shared page, so that a
+ * process which later gets the same ID cannot map them. Pages it
+ * has mapped are not affected; drop them with memory_free.
+ *
+ * Parameters:
+ *     pid: Process which has exited.
+ */
+void memory_shared_revoke(int pid)
+{
+    for (int i = 0; i < SHARED_MAX; i++)
+    {
+        shared_table[i].granted &= (uint16_t)~((uint16_t)1 << pid);
+    }
 }
@@ -0,0 +1,156 @@
+#include <string.h>
+
+#include <include/pipe.h>
+#include <include/scheduler.h>
+
+typedef struct _Pipe_T
+{
+    char data[PIPE_SIZE];
+    uint8_t head;
+    uint8_t tail;
+    uint8_t count;
+
+    uint8_t readers;
+    uint8_t writers;
+    bool used;
+} Pipe_T;
+
+Pipe_T pipe_table[PIPES_MAX];
+
+void pipe_init(void)
+{
+    for (int i = 0; i < PIPES_MAX; i++)
+    {
+        pipe_table[i].used = false;
+    }
+}
+
+int pipe_create(void)
+{
+    for (int i = 0; i < PIPES_MAX; i++)
+    {
+        Pipe_T * p = &pipe_table[i];
+        if (p->used) continue;
+
+        p->head = 0;
+        p->tail = 0;
+        p->count = 0;
+        p->readers = 0;
+        p->writers = 0;
+        p->used = true;
+
+        return i;
+    }
+
+    return E_NOPIPES;
+}
+
+bool pipe_valid(int id)
+{
+    return id >= 0 && id < PIPES_MAX && pipe_table[id].used;
+}
+
+void pipe_attach(int id, bool write)
+{
+    if (write) pipe_table[id].writers++;
+    else pipe_table[id].readers++;
+
+    scheduler_broadcast_event(EVENT_PIPE, -1);
+}
+
+void pipe_detach(int id, bool write)
+{
+    Pipe_T * p = &pipe_table[id];
+
+    if (write) p->writers--;
+    else p->readers--;
+
+    if (p->readers == 0 && p->writers == 0) p->used = false;
+
+    /* Readers may now be at end-of-file, and
+     * writers may have no one to write to. */
+    scheduler_broadcast_event(EVENT_PIPE, -1);
+}
+
+size_t pipe_write(int id, const char * s, size_t count)
+{
+    Pipe_T * p = &pipe_table[id];
+
+    /* Nobody to read it. */
+    if (p->readers == 0) return count;
+
+    size_t n = PIPE_SIZE - p->count;
+    if (n > count) n = count;
+    if (n == 0)
+    {
+        scheduler_block_current(EVENT_PIPE);
+        return 0;
+    }
+
+    /* Readers only wait on an empty pipe. */
+    bool was_empty = (p->count == 0);
+
+    /* Copy in at most two pieces, either side of the wrap. */
+    size_t first = PIPE_SIZE - p->head;
+    if (first > n) first = n;
+
+    memcpy(&p->data[p->head], s, first);
+    memcpy(&p->data[0], s + first, n - first);
+
+    p->head = (uint8_t)((p->head + n) & (PIPE_SIZE - 1));
+    p->count += (uint8_t)n;
+
+    if (was_empty) scheduler_broadcast_event(EVENT_PIPE, scheduler_current_pid());
+    if (n < count) scheduler_block_current(EVENT_PIPE);
+
+    return n;
+}
+
+int pipe_read(int id)
+{
+    Pipe_T * p = &pipe_table[id];
+
+    if (p->count == 0)
+    {
+        if (p->writers == 0) return PIPE_EOF;
+
+        scheduler_block_current(EVENT_PIPE);
+        return PIPE_BLOCKED;
+    }
+
+    /* Writers only wait on a full pipe. */
+    if (p->count == PIPE_SIZE) scheduler_broadcast_event(EVENT_PIPE, scheduler_current_pid());
+
+    uint8_t c = (uint8_t)p->data[p->tail];
+    p->tail = (uint8_t)((p->tail + 1) & (PIPE_SIZE - 1));
+    p->count--;
+
+    return c;
+}
+
+int pipe_readn(int id, char * buf, size_t max)
+{
+    Pipe_T * p = &pipe_table[id];
+
+    if (p->count == 0)
+    {
+        if (p->writers == 0) return PIPE_EOF;
+
+        scheduler_block_current(EVENT_PIPE);
+        return PIPE_BLOCKED;
+    }
+
+    if (p->count == PIPE_SIZE) scheduler_broadcast_event(EVENT_PIPE, scheduler_current_pid());
+
+    size_t n = p->count;
+    if (n > max) n = max;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        buf[i] = p->data[p->tail];
+        p->tail = (uint8_t)((p->tail + 1) & (PIPE_SIZE - 1));
+    }
+    p->count -= (uint8_t)n;
+
+    return (int)n;
+}
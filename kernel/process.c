@@ -3,6 +3,8 @@
 #include <string.h>
 
 #include <include/file.h>
+#include <include/lz.h>
+#include <include/pipe.h>
 #include <include/process.h>
 #include <include/memory.h>
 #include <include/ram.h>
@@ -18,20 +20,55 @@ typedef int (*Command_T)(char **, size_t);
 
 #define PHDR_ID 0
 #define PHDR_ID_EXEC 0x0a
+#define PHDR_ID_EXEC2 0x0c
+#define PHDR_ID_EXEC2_LZ 0x0d
 
 #define PHDR_PAGE 1
 #define USER_RAM_START_PAGE 0x80
 
-#define PROCS_MAX 16
+#define USER_RAM_START 0x8000
+#define USER_RAM_END (USER_RAM_START + PROGRAM_KB_LIMIT)
+
+/* Version 2 executable header.
+ * The first two bytes match the version 1 header.
+ * Code is loaded at the base address and data at data_address,
+ * both straight from the file, or decompressed from it if the
+ * header ID is PHDR_ID_EXEC2_LZ. The BSS is not stored in the file
+ * and is zeroed by the loader.
+ */
+typedef struct _ProgramHeader_T
+{
+    uint8_t id;
+    uint8_t page;
+    uint16_t entry;
+    uint16_t code_size;
+    uint16_t data_address;
+    uint16_t data_size;
+    uint16_t bss_address;
+    uint16_t bss_size;
+} ProgramHeader_T;
+
+extern FileDescriptor_T fdtable[FILE_LIMIT];
+
+void interrupt_disable(void);
 
 ProcessDescriptor_T process_table[PROCS_MAX];
 
+ProcessDescriptor_T * process_current_ptr;
+
 void process_init(void)
 {
     for (int i = 0; i < PROCS_MAX; i++)
     {
         process_table[i].base_address = 0x0000;
+        memset(process_table[i].banks, PROCESS_NO_BANK, PROCESS_BANKS_MAX);
+        process_table[i].pipe_in = PIPE_NONE;
+        process_table[i].pipe_out = PIPE_NONE;
     }
+
+    /* Anything accounted before the first process is scheduled
+     * is charged to the first process table entry. */
+    process_current_ptr = &process_table[0];
 #ifdef DEBUG
     process_table[0].base_address = 0x8000;
     process_table[0].bank = 0;
@@ -47,7 +84,10 @@ const ProcessDescriptor_T * process_info(int pid)
     return &process_table[pid];
 }
 
-ProcessDescriptor_T * process_current_ptr;
+ProcessDescriptor_T * process_descriptor(int pid)
+{
+    return &process_table[pid];
+}
 
 ProcessDescriptor_T * process_current(void)
 {
@@ -59,44 +99,82 @@ void process_set_current(int pid)
     process_current_ptr = &process_table[pid];
 }
 
-#define process_argc ((char *)0xf800)
-#define process_argv ((char *)0xf810)
-#define process_args ((char *)0xf820)
+int process_get_info(int pid, ProcessInfo_T * info)
+{
+    if (pid < 0 || pid >= PROCS_MAX) return E_NOPROCESS;
+
+    const ProcessDescriptor_T * p = &process_table[pid];
+    if (p->base_address == 0x0000) return E_NOPROCESS;
+
+    info->state = scheduler_state(pid);
+    info->bank = p->bank;
+    info->base_address = p->base_address;
+    memcpy(&info->stats, &p->stats, sizeof(ProcessStats_T));
+
+    return 0;
+}
+
+/* Arguments are copied to the start of the per-process area
+ * as a single block:
+ *
+ *     0x00: argc
+ *     0x10: argv (argc pointers)
+ *     then: argument strings
+ */
+#define PROCESS_AREA 0xf800
+#define PROCESS_AREA_END 0xfffe
+
+#define ARGC_OFFSET 0x00
+#define ARGV_OFFSET 0x10
+
+#define ARGS_MAX 16
+
+/* Largest argument block. Built on the caller's stack. */
+#define ARG_BLOCK_MAX 544
+
+#if (PROCESS_AREA + ARG_BLOCK_MAX) > PROCESS_AREA_END
+#error "Argument block does not fit in per-process area"
+#endif
+
+#define PUT_UINT16(_buf, _i, _v) (*(uint16_t *)&_buf[_i] = (uint16_t)(_v))
 
 int process_spawn(int pd, char ** argv, size_t argc)
 {
-    /* Copy argv strings onto stack. */
-    char arg_buffer[512];
-    char * arg_buffer_ptr = arg_buffer;
+    if (argc > ARGS_MAX) return E_TOOMANYARGS;
+
+    char block[ARG_BLOCK_MAX];
 
-    char * argv_buffer[16];
+    memset(block, 0, ARGV_OFFSET);
+    PUT_UINT16(block, ARGC_OFFSET, argc);
+
+    /* Strings follow the argv array. */
+    size_t size = ARGV_OFFSET + (argc * sizeof(uint16_t));
 
     for (size_t i = 0; i < argc; i++)
     {
-        char * s1 = argv[i];
-        size_t l = strlen(s1);
-
-        char * s = strcpy(arg_buffer_ptr, s1);
-        
-        /* Calculate offset into buffer of the string. */
-        char * buf_addr = (s - arg_buffer) + process_args;
-        argv_buffer[i] = buf_addr;
-        
-        arg_buffer_ptr += l + 1;
-    }
+        size_t l = strlen(argv[i]) + 1;
+        if (size + l > ARG_BLOCK_MAX) return E_ARGSTOOLONG;
 
-    uint8_t bank = process_table[pd].bank;
+        memcpy(&block[size], argv[i], l);
 
-    size_t argc_local = argc;
+        /* Pointer to the string as seen by the new process. */
+        PUT_UINT16(block, ARGV_OFFSET + (i * sizeof(uint16_t)), PROCESS_AREA + size);
 
-    ram_copy(process_argc, bank, (char*) &argc_local, 2);
-    ram_copy(process_argv, bank, (char*) argv_buffer, 16);
-    ram_copy(process_args, bank, arg_buffer, 512);
+        size += l;
+    }
+
+    ram_copy((char *)PROCESS_AREA, process_table[pd].bank, block, size);
 
     /* Create a scheduler entry for this process. */
     int success = scheduler_add(pd);
     if (success) return success;
-    else return 0;
+
+    /* A process started from the foreground, or the first
+     * process, runs in the foreground. */
+    int active = terminal_active_pid();
+    if (active == TERMINAL_NONE || active == scheduler_current_pid()) terminal_set_active(pd);
+
+    return 0;
 }
 
 int process_allocate(void)
@@ -115,7 +193,18 @@ uint8_t current_bank;
 char * p;
 char * user_ram_ptr;
 int fd;
-char base_address_high_byte;
+int load_error;
+int load_bank;
+int cache_page;
+ProgramHeader_T phdr;
+
+/* Returns non-zero if the segment lies within the program area. */
+static int process_segment_valid(uint16_t address, uint16_t size)
+{
+    if (size == 0) return 1;
+    if (address < USER_RAM_START || address >= USER_RAM_END) return 0;
+    return size <= USER_RAM_END - address;
+}
 
 /* pload syscall
  *
@@ -138,41 +227,106 @@ int process_load(const char * filename)
     if (fd < 0) return fd;
 
     /* Read header of executable file. */
-    char header[PHDR_SIZE];
-    size_t header_size = file_read(header, PHDR_SIZE, fd);
+    size_t header_size = file_read((char *)&phdr, PHDR_SIZE, fd);
 
     /* Check header size. We should have loaded the right number of bytes. */
     if (header_size != PHDR_SIZE) return E_INVALIDHEADER;
 
-    /* Check header byte. 0x0a is executable file. */
-    if (header[PHDR_ID] != PHDR_ID_EXEC) return E_INVALIDHEADER;
+    /* Check header byte. 0x0a is a version 1 executable,
+     * 0x0c is version 2 and 0x0d is compressed version 2. */
+    if (phdr.id != PHDR_ID_EXEC && phdr.id != PHDR_ID_EXEC2 && phdr.id != PHDR_ID_EXEC2_LZ) return E_INVALIDHEADER;
 
     /* Base address page is second byte of header. */
-    uintptr_t base_addr_page = header[PHDR_PAGE];
+    uintptr_t base_addr_page = phdr.page;
+
+    uintptr_t base_addr = base_addr_page << 8;
 
     /* Check page is valid. */
     if (base_addr_page < USER_RAM_START_PAGE) return E_INVALIDPAGE;
+    if (base_addr >= USER_RAM_END) return E_INVALIDPAGE;
+
+    if (phdr.id != PHDR_ID_EXEC)
+    {
+        /* Read the rest of the version 2 header. */
+        header_size = file_read((char *)&phdr + PHDR_SIZE, sizeof(ProgramHeader_T) - PHDR_SIZE, fd);
+        if (header_size != sizeof(ProgramHeader_T) - PHDR_SIZE) return E_INVALIDHEADER;
+
+        if (!process_segment_valid(base_addr, phdr.code_size)) return E_INVALIDHEADER;
+        if (!process_segment_valid(phdr.data_address, phdr.data_size)) return E_INVALIDHEADER;
+        if (!process_segment_valid(phdr.bss_address, phdr.bss_size)) return E_INVALIDHEADER;
+
+        /* Entry point must be within the code. */
+        if (phdr.entry < base_addr || phdr.entry - base_addr >= phdr.code_size) return E_INVALIDHEADER;
+    }
+    else
+    {
+        /* Version 1 has no sizes, so read the rest of the file, up to
+         * the end of the program area, and enter at the base address. */
+        phdr.entry = base_addr;
+        phdr.code_size = USER_RAM_END - base_addr;
+        if (fdtable[fd].size - PHDR_SIZE < phdr.code_size) phdr.code_size = fdtable[fd].size - PHDR_SIZE;
+        phdr.data_size = 0;
+        phdr.bss_size = 0;
+    }
 
     /* Find the next available process descriptor. */
     int pd = process_allocate();
 
     /* Allocate a bank of memory and load the file into that page. */
-    int bank = memory_allocate();
-    uintptr_t base_addr = base_addr_page << 8;
+    load_bank = memory_allocate_for(pd);
     process_table[pd].base_address = base_addr;
-    process_table[pd].bank = bank;
+    process_table[pd].bank = load_bank;
 
     user_ram_ptr = user_ram(base_addr);
-    base_address_high_byte = (char)base_addr_page;
 
-    /* Otherwise read the contents of the file
-     * and write to user RAM. */
+    /* Look for a cached copy only after allocating, in case
+     * the allocation had to reclaim the cached page. */
+    cache_page = memory_cache_find(fdtable[fd].start_cluster, fdtable[fd].size);
+
     current_bank = ram_bank_current();
-    
-    ram_bank_set(process_table[pd].bank);
 
-    file_read(user_ram_ptr, PROGRAM_KB_LIMIT, fd);
-    
+    load_error = 0;
+
+    if (cache_page >= 0)
+    {
+        /* Copy the pristine image from the cache. */
+        ram_copy_banks(user_ram_ptr, load_bank, user_ram_ptr, cache_page, phdr.code_size);
+        if (phdr.data_size) ram_copy_banks(user_ram((uintptr_t)phdr.data_address), load_bank, user_ram((uintptr_t)phdr.data_address), cache_page, phdr.data_size);
+
+        ram_bank_set(load_bank);
+    }
+    else
+    {
+        /* Otherwise read the contents of the file
+         * and write to user RAM. */
+        ram_bank_set(load_bank);
+
+        if (phdr.id == PHDR_ID_EXEC2_LZ)
+        {
+            lz_begin(fd);
+            load_error = lz_decode(user_ram_ptr, phdr.code_size);
+            if (!load_error) load_error = lz_decode(user_ram((uintptr_t)phdr.data_address), phdr.data_size);
+        }
+        else
+        {
+            file_read(user_ram_ptr, phdr.code_size, fd);
+            if (phdr.data_size) file_read(user_ram((uintptr_t)phdr.data_address), phdr.data_size, fd);
+        }
+
+        /* Keep a copy, before the process has a chance to modify it. */
+        if (!load_error)
+        {
+            cache_page = memory_cache_allocate(fdtable[fd].start_cluster, fdtable[fd].size);
+            if (cache_page >= 0)
+            {
+                ram_copy(user_ram_ptr, cache_page, user_ram_ptr, phdr.code_size);
+                if (phdr.data_size) ram_copy(user_ram((uintptr_t)phdr.data_address), cache_page, user_ram((uintptr_t)phdr.data_address), phdr.data_size);
+            }
+        }
+    }
+
+    if (phdr.bss_size) memset(user_ram((uintptr_t)phdr.bss_address), 0, phdr.bss_size);
+
     p = (char*)0xffff;
 
     /* Stack pointer on entry. */
@@ -195,16 +349,27 @@ int process_load(const char * filename)
     *p-- = 0x00;
 
     /* Entry point. */
-    *p-- = base_address_high_byte;
-    *p-- = 0x00;
+    *p-- = (char)(phdr.entry >> 8);
+    *p-- = (char)(phdr.entry & 0xff);
 
     ram_bank_set(current_bank);
 
+    if (load_error)
+    {
+        memory_free(process_table[pd].bank);
+        process_table[pd].base_address = 0x0000;
+        return E_INVALIDHEADER;
+    }
+
     /* Set other process attributes. */
+    memset(&process_table[pd].stats, 0, sizeof(ProcessStats_T));
     process_table[pd].termstatus = 0;
     process_table[pd].sigstatus = 0;
     process_table[pd].sighandlers.cancel = NULL;
     process_table[pd].sighandlers.brk = NULL;
+    memset(process_table[pd].banks, PROCESS_NO_BANK, PROCESS_BANKS_MAX);
+    process_table[pd].pipe_in = PIPE_NONE;
+    process_table[pd].pipe_out = PIPE_NONE;
 
     /* Update address. Return process descriptor. */
     return pd;
@@ -214,4 +379,244 @@ void process_exit(int code)
 {
     int s = scheduler_current_pid();
     scheduler_exit(s, code);
+
+    /* The bank is not used again once we switch away, and nothing
+     * else can allocate it before then as syscalls run with
+     * interrupts disabled. Freeing it lets the image cache use it. */
+    memory_free(process_table[s].bank);
+
+    for (int i = 0; i < PROCESS_BANKS_MAX; i++)
+    {
+        process_bank_free(i);
+    }
+
+    /* The process ID may be used again. */
+    memory_shared_revoke(s);
+
+    /* Lets the other end of each pipe see end-of-file. */
+    process_redirect(s, PIPE_NONE, PIPE_NONE);
+
+    terminal_exit(s);
+}
+
+int process_redirect(int pd, int in, int out)
+{
+    if (pd < 0 || pd >= PROCS_MAX) return E_NOPROCESS;
+    if (process_table[pd].base_address == 0x0000) return E_NOPROCESS;
+
+    if (in != PIPE_NONE && !pipe_valid(in)) return E_NOPIPE;
+    if (out != PIPE_NONE && !pipe_valid(out)) return E_NOPIPE;
+
+    ProcessDescriptor_T * p = &process_table[pd];
+
+    /* Attach before detaching, so that reconnecting the
+     * same pipe does not free it in between. */
+    if (in != PIPE_NONE) pipe_attach(in, false);
+    if (out != PIPE_NONE) pipe_attach(out, true);
+
+    if (p->pipe_in != PIPE_NONE) pipe_detach(p->pipe_in, false);
+    if (p->pipe_out != PIPE_NONE) pipe_detach(p->pipe_out, true);
+
+    p->pipe_in = (int8_t)in;
+    p->pipe_out = (int8_t)out;
+
+    return 0;
+}
+
+int process_free(int pd)
+{
+    if (pd < 0 || pd >= PROCS_MAX) return E_NOPROCESS;
+    if (process_table[pd].base_address == 0x0000) return E_NOPROCESS;
+
+    /* Once spawned, the process frees its bank when it exits. */
+    if (scheduler_state(pd) != TASK_FREE) return E_NOPROCESS;
+
+    process_redirect(pd, PIPE_NONE, PIPE_NONE);
+    memory_shared_revoke(pd);
+
+    memory_free(process_table[pd].bank);
+    process_table[pd].base_address = 0x0000;
+
+    return 0;
+}
+
+/* Registers for the clone's first context switch, in the order the
+ * timer handler unstacks them. Global, as it is copied out while
+ * the caller's stack is in another bank. */
+uint16_t clone_frame[7];
+uint16_t clone_sp;
+
+int process_clone(uint16_t sp, uint16_t pc, uint16_t ix)
+{
+    int pd = process_allocate();
+    if (pd < 0) return E_NOPROCESS;
+
+    int bank = memory_allocate_for(pd);
+    if (bank < 0) return E_NOBANKS;
+
+    ProcessDescriptor_T * parent = process_current();
+    ProcessDescriptor_T * child = &process_table[pd];
+
+    /* The whole bank, including the stack, is copied
+     * as it stands on entry to the syscall. */
+    ram_copy_banks(user_ram(USER_RAM_START), (uint8_t)bank, user_ram(USER_RAM_START), parent->bank, PROCESS_BANK_SIZE);
+
+    /* An interrupt during the copy stacks its registers in whichever
+     * bank is selected, below the kernel's stack pointer. In the copy
+     * that is below the caller's stack, so nothing is lost, but the
+     * clone's first frame is written there next. */
+    interrupt_disable();
+
+    /* The clone resumes at the syscall's return address,
+     * with 0 as the return value in DE. */
+    clone_frame[0] = 0;     /* IY */
+    clone_frame[1] = ix;    /* IX */
+    clone_frame[2] = 0;     /* BC */
+    clone_frame[3] = 0;     /* DE */
+    clone_frame[4] = 0;     /* HL */
+    clone_frame[5] = 0;     /* AF */
+    clone_frame[6] = pc;
+
+    clone_sp = sp - sizeof(clone_frame);
+    ram_copy(user_ram((uintptr_t)clone_sp), (uint8_t)bank, (char *)clone_frame, sizeof(clone_frame));
+    ram_copy(user_ram(0xfffe), (uint8_t)bank, (char *)&clone_sp, sizeof(clone_sp));
+
+    /* Auxiliary banks and the active terminal are
+     * not inherited, but pipes are. */
+    *child = *parent;
+    child->bank = (uint8_t)bank;
+    memset(&child->stats, 0, sizeof(ProcessStats_T));
+    child->sigstatus = 0;
+    child->termstatus &= (termstatus_t)~(TERMSTATUS_ACTIVE | TERMSTATUS_AVAILABLE);
+    memset(child->banks, PROCESS_NO_BANK, PROCESS_BANKS_MAX);
+    child->pipe_in = PIPE_NONE;
+    child->pipe_out = PIPE_NONE;
+
+    if (scheduler_add(pd) < 0)
+    {
+        memory_free(bank);
+        child->base_address = 0x0000;
+        return E_NOPROCESS;
+    }
+
+    process_redirect(pd, parent->pipe_in, parent->pipe_out);
+
+    return pd;
+}
+
+/* Gives the current process a bank in its first free slot.
+ * Returns the handle, or E_NOBANKS if all slots are in use. */
+static int process_bank_attach(int bank)
+{
+    ProcessDescriptor_T * p = process_current();
+
+    for (int i = 0; i < PROCESS_BANKS_MAX; i++)
+    {
+        if (p->banks[i] != PROCESS_NO_BANK) continue;
+
+        p->banks[i] = (uint8_t)bank;
+        return i;
+    }
+
+    return E_NOBANKS;
+}
+
+int process_bank_alloc(void)
+{
+    int bank = memory_allocate_for(scheduler_current_pid());
+    if (bank < 0) return E_NOBANKS;
+
+    int handle = process_bank_attach(bank);
+    if (handle < 0) memory_free(bank);
+
+    return handle;
+}
+
+int process_shared_alloc(uint8_t * id)
+{
+    int shared = memory_shared_allocate(scheduler_current_pid());
+    if (shared < 0) return E_NOBANKS;
+
+    /* The creator's mapping holds the first reference. */
+    int bank = memory_shared_page(shared);
+
+    int handle = process_bank_attach(bank);
+    if (handle < 0)
+    {
+        memory_free(bank);
+        return handle;
+    }
+
+    *id = (uint8_t)shared;
+    return handle;
+}
+
+int process_shared_grant(int id, int pid)
+{
+    if (pid < 0 || pid >= PROCS_MAX) return E_NOPROCESS;
+
+    return memory_shared_grant(id, pid, scheduler_current_pid());
+}
+
+int process_shared_map(int id)
+{
+    int bank = memory_shared_map(id, scheduler_current_pid());
+    if (bank < 0) return bank;
+
+    int handle = process_bank_attach(bank);
+    if (handle < 0) memory_free(bank);
+
+    return handle;
+}
+
+int process_bank_free(int handle)
+{
+    ProcessDescriptor_T * p = process_current();
+
+    if (handle < 0 || handle >= PROCESS_BANKS_MAX) return E_NOBANK;
+    if (p->banks[handle] == PROCESS_NO_BANK) return E_NOBANK;
+
+    memory_free(p->banks[handle]);
+    p->banks[handle] = PROCESS_NO_BANK;
+
+    return 0;
+}
+
+/* Validates a copy between the caller and one of its banks.
+ * Returns the bank number, or an error code. */
+static int process_bank_check(int handle, uint16_t offset, const char * buf, size_t n)
+{
+    ProcessDescriptor_T * p = process_current();
+
+    if (handle < 0 || handle >= PROCESS_BANKS_MAX) return E_NOBANK;
+    if (p->banks[handle] == PROCESS_NO_BANK) return E_NOBANK;
+
+    if (offset > PROCESS_BANK_SIZE || n > PROCESS_BANK_SIZE - offset) return E_BANKRANGE;
+
+#ifndef UNIT_TEST
+    /* The caller's buffer must be in its own bank. */
+    if ((uintptr_t)buf < 0x8000 || n > 0x10000 - (uintptr_t)buf) return E_BANKRANGE;
+#else
+    (void)buf;
+#endif
+
+    return p->banks[handle];
+}
+
+int process_bank_read(int handle, uint16_t offset, char * buf, size_t n)
+{
+    int bank = process_bank_check(handle, offset, buf, n);
+    if (bank < 0) return bank;
+
+    ram_copy_banks(buf, ram_bank_current(), user_ram((uintptr_t)0x8000 + offset), (uint8_t)bank, n);
+    return (int)n;
+}
+
+int process_bank_write(int handle, uint16_t offset, const char * buf, size_t n)
+{
+    int bank = process_bank_check(handle, offset, buf, n);
+    if (bank < 0) return bank;
+
+    ram_copy_banks(user_ram((uintptr_t)0x8000 + offset), (uint8_t)bank, (char *)buf, ram_bank_current(), n);
+    return (int)n;
 }
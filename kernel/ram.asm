@@ -4,77 +4,216 @@
     .equ    BANK_SELECT, 0x30
     .equ    BANKED_MEM_TEST, 0x8000
 
+    ; Size of the bounce buffer used when copying between banks.
+    .equ    RAM_COPY_CHUNK, 256
+
 _dst_bank:
     .ds     #1
-_byte:
+_src_bank:
     .ds     #1
+_ram_copy_remaining:
+    .ds     #2
+_ram_copy_chunk:
+    .ds     #2
+_ram_copy_src:
+    .ds     #2
+_ram_copy_dst:
+    .ds     #2
+
+    ; Bounce buffer in low RAM, visible from every bank.
+_ram_copy_buffer:
+    .ds     #RAM_COPY_CHUNK
+
+    ; void ram_copy_banks(char * dst, uint8_t dst_bank, char * src, uint8_t src_bank, size_t n)
+    ;
+    ; Copies data between any two RAM banks.
+    ;
+    ; C entry point. Parameters are passed on the stack;
+    ; they are loaded into registers and the register entry
+    ; point (__ram_copy_banks) is used.
+    ;
+    ; NOT REENTRANT.
+    .globl  _ram_copy_banks
+_ram_copy_banks:
+    push    IX
+
+    ld      IX, #4
+    add     IX, SP
+
+    ; Get n into BC
+    ld      C, 6(IX)
+    ld      B, 7(IX)
+
+    ; Get source bank.
+    ld      A, 5(IX)
+    ld      (_src_bank), A
+
+    ; Get src into HL
+    ld      L, 3(IX)
+    ld      H, 4(IX)
+
+    ; Get dst into DE.
+    ld      E, 0(IX)
+    ld      D, 1(IX)
+
+    ; Get destination bank into A.
+    ld      A, 2(IX)
+
+    pop     IX
+
+    jp      __ram_copy_banks
 
     ; void ram_copy(char * dst, uint8_t bank, char * src, size_t n)
     ;
     ; Copies data from one RAM bank to another.
     ;
-    ; NOT REENTRANT.
+    ; C entry point. Parameters are passed on the stack;
+    ; they are loaded into registers and the register entry
+    ; point (__ram_copy) is used.
     ;
-    ; TODO: CALLING CONVENTION!!!
+    ; NOT REENTRANT.
     .globl  _ram_copy
 _ram_copy:
     push    IX
 
-    ld      HL, #4
-    add     HL, SP
-    push    HL
-    pop     IX
+    ld      IX, #4
+    add     IX, SP
 
     ; Get n into BC
     ld      C, 5(IX)
     ld      B, 6(IX)
 
-    ; Get src into DE
-    ld      E, 3(IX)
-    ld      D, 4(IX)
+    ; Get src into HL
+    ld      L, 3(IX)
+    ld      H, 4(IX)
+
+    ; Get dst into DE.
+    ld      E, 0(IX)
+    ld      D, 1(IX)
 
-    ; Get bank into A, store for later use.
+    ; Get bank into A.
     ld      A, 2(IX)
+
+    pop     IX
+
+    ; Fall through to register entry point.
+
+    ; __ram_copy
+    ;
+    ; Register entry point for ram_copy.
+    ;
+    ; HL: Source pointer (in current bank)
+    ; DE: Destination pointer (in destination bank)
+    ; BC: Number of bytes to copy
+    ; A:  Destination bank
+    ;
+    ; Copies in chunks of up to RAM_COPY_CHUNK bytes: each chunk
+    ; is copied into a bounce buffer in low RAM with LDIR, then
+    ; the destination bank is selected and the chunk copied out
+    ; with a second LDIR. The bank is switched twice per chunk
+    ; rather than twice per byte.
+    ;
+    ; If the source lies entirely in low RAM, no bounce buffer
+    ; is needed and the data is copied with a single LDIR.
+    ;
+    ; The stack is not used while another bank is selected,
+    ; as the stack may be in banked memory.
+    ;
+    ; Trashes all registers. NOT REENTRANT.
+    .globl  __ram_copy
+    .globl  __ram_copy_done ; Required for benchmarking.
+__ram_copy:
+    push    AF
+    ld      A, (_bank_current)
+    ld      (_src_bank), A
+    pop     AF
+
+    ; __ram_copy_banks
+    ;
+    ; As __ram_copy, but the source bank is taken from _src_bank
+    ; rather than being the current bank.
+    .globl  __ram_copy_banks
+__ram_copy_banks:
     ld      (_dst_bank), A
 
-    ; Get dst into HL.
-    ld      L, 0(IX)
-    ld      H, 1(IX)
+    ; Nothing to do if count is #0.
+    ld      A, B
+    or      C
+    jp      z, __ram_copy_done
 
-    ; NO STACK USAGE BEYOND HERE!
+    ; Is the last source byte in banked memory?
+    push    HL
+    add     HL, BC
+    dec     HL
+    ld      A, H
+    pop     HL
 
-__ram_copy_loop:
-    ; Read byte to copy.
-    ld      A, (DE)
-    ld      (_byte), A
+    ; Is the first source byte in banked memory?
+    or      H
+    bit     #7, A
+    jp      nz, __ram_copy_bounce
 
-    ; Switch to destination bank.
+    ; Source is in low RAM. Copy directly.
     ld      A, (_dst_bank)
     out     (BANK_SELECT), A
-
-    ; Write byte to destination (in HL).
-    ld      A, (_byte)
-    ld      (HL), A
-
-    ; Switch back to original bank.
+    ldir
     ld      A, (_bank_current)
     out     (BANK_SELECT), A
+    jp      __ram_copy_done
 
-    ; Increment pointers, decrement count.
-    inc     HL
-    inc     DE
-    dec     BC
+__ram_copy_bounce:
+    ld      (_ram_copy_remaining), BC
+    ld      (_ram_copy_dst), DE
 
-    ; If count is #0, exit loop.
+__ram_copy_loop:
+    ; Chunk size is the smaller of the remaining count
+    ; and the size of the bounce buffer.
+    ld      BC, (_ram_copy_remaining)
     ld      A, B
-    or      C
+    or      A
+    jp      z, __ram_copy_small
+    ld      BC, #RAM_COPY_CHUNK
+__ram_copy_small:
+    ld      (_ram_copy_chunk), BC
+
+    ; Switch to source bank and copy chunk into bounce buffer.
+    ; HL is left pointing at the next source byte.
+    ld      A, (_src_bank)
+    out     (BANK_SELECT), A
+    ld      DE, #_ram_copy_buffer
+    ldir
+    ld      (_ram_copy_src), HL
+
+    ; Switch to destination bank and copy chunk out.
+    ; DE is left pointing at the next destination byte.
+    ld      HL, #_ram_copy_buffer
+    ld      DE, (_ram_copy_dst)
+    ld      BC, (_ram_copy_chunk)
+    ld      A, (_dst_bank)
+    out     (BANK_SELECT), A
+    ldir
+    ld      (_ram_copy_dst), DE
+
+    ; Decrement remaining count by chunk size.
+    ld      HL, (_ram_copy_remaining)
+    ld      BC, (_ram_copy_chunk)
+    or      A
+    sbc     HL, BC
+    ld      (_ram_copy_remaining), HL
+    ld      A, H
+    or      L
+    ld      HL, (_ram_copy_src)
     jp      nz, __ram_copy_loop
 
+    ; Switch back to original bank.
+    ld      A, (_bank_current)
+    out     (BANK_SELECT), A
+
     ; Done copying, now on original bank.
 __ram_copy_done:
-    pop     IX
     ret
 
+    .globl  _bank_current
 _bank_current:
     .byte   0
 
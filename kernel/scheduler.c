@@ -2,6 +2,7 @@
 
 #include <include/process.h>
 #include <include/ram.h>
+#include <include/trace.h>
 
 #include <stdint.h>
 
@@ -11,14 +12,30 @@ typedef struct _ScheduleTableEntry_T
     EventType_T blocking_event;
     int pid;
     int exitcode;
+    uint16_t sleep_delta;
+    int8_t sleep_next;
 } ScheduleTableEntry_T;
 
 #define MAX_SCHEDULED 16
 
+#define SLEEP_QUEUE_END -1
+
 int current_scheduled;
 int num_scheduled;
 ScheduleTableEntry_T schedule_table[MAX_SCHEDULED];
 
+/* Kernel tick counter. Incremented by the timer interrupt
+ * handler on every tick, including those on which the scheduler
+ * does not run. */
+uint16_t scheduler_ticks;
+
+/* Sleeping tasks are kept in a delta list, ordered by wake time.
+ * Each entry's sleep_delta is the number of ticks after the
+ * previous entry that it should be woken, so only the head of
+ * the list needs to be updated on each tick. */
+int8_t sleep_queue;
+uint16_t sleep_last_tick;
+
 void scheduler_init(void)
 {
     for (int i = 0; i < MAX_SCHEDULED; i++)
@@ -27,6 +44,12 @@ void scheduler_init(void)
     }
     current_scheduled = -1;
     num_scheduled = 0;
+
+    scheduler_ticks = 0;
+    sleep_queue = SLEEP_QUEUE_END;
+    sleep_last_tick = 0;
+
+    trace_init();
 #ifdef DEBUG
     schedule_table[0].state = TASK_READY;
     schedule_table[0].pid = 0;
@@ -74,6 +97,64 @@ void scheduler_broadcast_event(EventType_T event, int exclude_pid)
         
         schedule_table[i].state = TASK_READY;
         schedule_table[i].blocking_event = EVENT_NO_EVENT;
+
+        TRACE(TRACE_WAKE, schedule_table[i].pid, event);
+    }
+}
+
+/* Helper function to remove a task from the sleep queue, if present. */
+void scheduler_sleep_remove(int s)
+{
+    int8_t * link = &sleep_queue;
+
+    while (*link != SLEEP_QUEUE_END)
+    {
+        if (*link == s)
+        {
+            /* Give the remaining delta to the next sleeper
+             * so its wake time is unchanged. */
+            int8_t next = schedule_table[s].sleep_next;
+            if (next != SLEEP_QUEUE_END)
+            {
+                schedule_table[next].sleep_delta += schedule_table[s].sleep_delta;
+            }
+
+            *link = next;
+            return;
+        }
+
+        link = &schedule_table[*link].sleep_next;
+    }
+}
+
+/* Helper function to wake any sleeping tasks which are due.
+ * Handles any number of elapsed ticks, so ticks missed while
+ * in kernel space are caught up on the next call. */
+void scheduler_sleep_update(void)
+{
+    uint16_t elapsed = scheduler_ticks - sleep_last_tick;
+    sleep_last_tick = scheduler_ticks;
+
+    while (sleep_queue != SLEEP_QUEUE_END)
+    {
+        ScheduleTableEntry_T * e = &schedule_table[sleep_queue];
+
+        if (e->sleep_delta > elapsed)
+        {
+            e->sleep_delta -= elapsed;
+            return;
+        }
+
+        elapsed -= e->sleep_delta;
+        sleep_queue = e->sleep_next;
+
+        if (e->state == TASK_BLOCKED && e->blocking_event == EVENT_TIMER)
+        {
+            e->state = TASK_READY;
+            e->blocking_event = EVENT_NO_EVENT;
+
+            TRACE(TRACE_WAKE, e->pid, EVENT_TIMER);
+        }
     }
 }
 
@@ -94,6 +175,10 @@ int scheduler_add(int pid)
 TaskState_T scheduler_state(int pid)
 {
     int s = scheduler_entry(pid);
+
+    /* Process has been loaded but not yet spawned. */
+    if (s < 0) return TASK_FREE;
+
     return schedule_table[s].state;
 }
 
@@ -103,6 +188,8 @@ void scheduler_exit(int pid, int exitcode)
     schedule_table[s].state = TASK_FINISHED;
     schedule_table[s].exitcode = exitcode;
 
+    scheduler_sleep_remove(s);
+
     /* A process has completed - broadcast an event. */
     scheduler_broadcast_event(EVENT_PROCESS_FINISHED, pid);
 }
@@ -133,16 +220,25 @@ int scheduler_next(void)
         schedule_table[current_scheduled].state = TASK_READY;
     }
 
-    /* Find the next READY task. */
-    while (1)
+    /* Find the next READY task. If every task is blocked
+     * (e.g. all are sleeping) then the current task keeps the CPU
+     * until a later tick makes one ready. */
+    int next = current_scheduled;
+    for (int i = 0; i < num_scheduled; i++)
     {
-        current_scheduled++;
-        if (current_scheduled >= num_scheduled) current_scheduled = 0;
-
-        if (schedule_table[current_scheduled].state == TASK_READY) break;
+        next++;
+        if (next >= num_scheduled) next = 0;
+
+        if (schedule_table[next].state == TASK_READY)
+        {
+            current_scheduled = next;
+            schedule_table[current_scheduled].state = TASK_RUNNING;
+            break;
+        }
     }
 
-    schedule_table[current_scheduled].state = TASK_RUNNING;
+    TRACE(TRACE_SWITCH, schedule_current_pid, schedule_table[current_scheduled].pid);
+
     schedule_current_pid = schedule_table[current_scheduled].pid;
     process_set_current(schedule_current_pid);
 
@@ -151,6 +247,11 @@ int scheduler_next(void)
 
 uint8_t scheduler_tick(void)
 {
+    /* Charge the tick to the task that was running. */
+    if (current_scheduled >= 0) process_current()->stats.ticks++;
+
+    scheduler_sleep_update();
+
     int pid = scheduler_next();
 
     const ProcessDescriptor_T * p = process_info(pid);
@@ -171,6 +272,8 @@ uint8_t scheduler_tick(void)
  */
 void scheduler_block_current(EventType_T event)
 {
+    TRACE(TRACE_BLOCK, schedule_current_pid, event);
+
     schedule_table[current_scheduled].blocking_event = event;
     schedule_table[current_scheduled].state = TASK_BLOCKED;
 }
@@ -190,6 +293,8 @@ void scheduler_block_current(EventType_T event)
  */
 void scheduler_block(int pid, EventType_T event)
 {
+    TRACE(TRACE_BLOCK, pid, event);
+
     int s = scheduler_entry(pid);
     schedule_table[s].blocking_event = event;
     schedule_table[s].state = TASK_BLOCKED;
@@ -211,3 +316,47 @@ EventType_T scheduler_event(int pid)
     int s = scheduler_entry(pid);
     return schedule_table[s].blocking_event;
 }
+
+/* scheduler_sleep
+ *
+ * Purpose:
+ *     Blocks the current task for the given number of ticks.
+ * 
+ * Parameters:
+ *     Number of ticks to sleep for
+ * 
+ * Returns:
+ *     Tick count at which the task will be woken.
+ */
+uint16_t scheduler_sleep(uint16_t ticks)
+{
+    /* Bring the queue up to date so that deltas
+     * are relative to the current tick. */
+    scheduler_sleep_update();
+
+    if (ticks == 0) return scheduler_ticks;
+
+    /* Find position in the delta list. Tasks with the same
+     * wake time are woken in the order they went to sleep. */
+    int8_t * link = &sleep_queue;
+    uint16_t delta = ticks;
+
+    while (*link != SLEEP_QUEUE_END && schedule_table[*link].sleep_delta <= delta)
+    {
+        delta -= schedule_table[*link].sleep_delta;
+        link = &schedule_table[*link].sleep_next;
+    }
+
+    if (*link != SLEEP_QUEUE_END)
+    {
+        schedule_table[*link].sleep_delta -= delta;
+    }
+
+    schedule_table[current_scheduled].sleep_delta = delta;
+    schedule_table[current_scheduled].sleep_next = *link;
+    *link = current_scheduled;
+
+    scheduler_block_current(EVENT_TIMER);
+
+    return scheduler_ticks + ticks;
+}
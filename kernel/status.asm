@@ -29,6 +29,9 @@
     .globl  _status_set_disk
     .globl  _status_clr_disk
 
+    ; Also updated directly by the syscall handler.
+    .globl  _current_status
+
     ; Current status of the LEDs.
 _current_status:
     .byte   #0
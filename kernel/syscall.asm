@@ -2,7 +2,7 @@
     .equ    UART_PORT_DATA, #0b00000001
     .equ    UART_PORT_CONTROL, #0b00000000
 
-    .globl  _driver_6850_tx
+    .globl  _terminal_write
 
     .globl  _file_open
     .globl  _file_read
@@ -23,33 +23,60 @@
 
     .globl  _signal_sethandler
 
+    .globl  _scheduler_sleep
+    .globl  _process_get_info
+    .globl  _trace_drain
+    .globl  _process_bank_alloc
+    .globl  _process_bank_free
+    .globl  _process_bank_read
+    .globl  _process_bank_write
+    .globl  _process_shared_alloc
+    .globl  _process_shared_grant
+    .globl  _process_shared_map
+    .globl  _pipe_create
+    .globl  _process_redirect
+    .globl  _process_clone
+    .globl  _terminal_set_active
+    .globl  _terminal_readline
+    .globl  _terminal_readn
+    .globl  _terminal_writev
+    .globl  _file_writev
+    .globl  _sysstat_read
+    .globl  _process_free
+    .globl  _do_swrite
+    .globl  _process_current_ptr
+    .globl  _scheduler_ticks
+    .globl  _memory_stats
+    .globl  _terminal_stats
+    .globl  __timer_handler_switch
+
     ; Syscall table.
 _syscall_table:
-    .word   _driver_6850_tx         ; swrite
-    .word   _terminal_get           ; sread
+    .word   _do_swrite               ; swrite
+    .word   _do_sread                ; sread
 
     ; DREAD, DWRITE no longer supported.
     .word   __invalid_syscall
     .word   __invalid_syscall
 
-    .word   _file_open               ; fopen
-    .word   _file_read               ; fread
-    .word   _file_write              ; fwrite
-    .word   _file_close              ; fclose
+    .word   _do_fopen                ; fopen
+    .word   _do_fread                ; fread
+    .word   _do_fwrite               ; fwrite
+    .word   _do_fclose               ; fclose
 
     .word   _do_dinfo                ; dinfo
-    .word   _file_info               ; finfo
+    .word   _do_finfo                ; finfo
 
-    .word   _file_entries            ; fentries
-    .word   _file_entry              ; fentry
+    .word   _do_fentries             ; fentries
+    .word   _do_fentry               ; fentry
 
     .word   _process_spawn           ; pspawn
 
     .word   _signal_sethandler       ; sighandle
 
-    .word   _file_delete             ; fdelete
+    .word   _do_fdelete              ; fdelete
     
-    .word   _process_load            ; pload
+    .word   _do_pload                ; pload
 
     .word   _terminal_set_mode       ; smode
 
@@ -59,98 +86,174 @@ _syscall_table:
     .word   _do_pexit                ; pexit
     .word   _scheduler_exitcode      ; pexitcode
     .word   _scheduler_block_current ; pblock
+    .word   _do_psleep               ; psleep
+    .word   _do_pyield               ; pyield
+    .word   _process_get_info        ; pinfo
+    .word   _trace_drain             ; tdrain
+    .word   _process_bank_alloc      ; balloc
+    .word   _process_bank_free       ; bfree
+    .word   _process_bank_read       ; bread
+    .word   _process_bank_write      ; bwrite
+    .word   _process_shared_alloc    ; shalloc
+    .word   _process_shared_grant    ; shgrant
+    .word   _process_shared_map      ; shmap
+    .word   _pipe_create             ; pipe
+    .word   _process_redirect        ; predirect
+    .word   _do_pclone               ; pclone
+    .word   _terminal_set_active     ; sactive
+    .word   _do_readline             ; readline
+    .word   _do_sreadn               ; sreadn
+    .word   _do_swritev              ; swritev
+    .word   _do_fwritev              ; fwritev
+    .word   _sysstat_read            ; sysstat
+    .word   _process_free            ; pfree
 
     .globl  _syscall_handler
 
-    .globl  _status_set_kernel
     .globl  _status_clr_kernel
 
+    ; The caller's return address and IX are kept in its own
+    ; per-process storage, rather than in kernel RAM, so that
+    ; they belong to the process making the syscall.
+    ; See PROCESS.md.
+    .equ    SYSCALL_RET_ADDRESS, 0xf80c
+    .equ    SYSCALL_IX, 0xf80e
+
+    ; KERNEL status, as in status.asm.
+    .globl  _current_status
+    .equ    STATUS_PORT, 0x80
+    .equ    STATUS_SETMASK_KERNEL, 0b00000100
+    .equ    STATUS_CLRMASK_KERNEL, 0b11111011
+
     ; Syscall handler.
     ;
     ; Calculates absolute position of syscall function address
     ; using offset provided in A, then executes the function at
     ; that address.
     ;
-    ; TODO: NOT REENTRANT!!!
+    ; Syscalls run with interrupts disabled, apart from those
+    ; which only touch the filesystem. The kernel is never
+    ; preempted, as the timer handler does not switch tasks
+    ; while the kernel status is set.
 _syscall_handler:
     di
 
-    ; Save IX as it will be trashed by syscall shim.
-    ld      (__syscall_ix), IX
+    ; Save IX as it is used as scratch below.
+    ld      (SYSCALL_IX), IX
 
-    ; Save HL, DE, BC as they may contain arguments.
-    push    HL
-    push    DE
-    push    BC
+    ; Swap the return address from the syscall for the
+    ; syscall return handler, keeping HL, which may hold
+    ; an argument. DE and BC are left alone throughout.
+    ex      (SP), HL
+    ld      (SYSCALL_RET_ADDRESS), HL
+    ld      HL, #__syscall_ret
 
-    ; Store return address from syscall.
-    ; Need to skip the three 16-bit registers on stack.
-    ld      HL, #6
-    add     HL, SP
-    ld      E, (HL)
-    inc     HL
-    ld      D, (HL)
-    ld      (__syscall_ret_address), DE
-
-    ; Set return address to the syscall return handler.
-    ld      DE, #__syscall_ret
-    ld      HL, #6
-    add     HL, SP
-    ld      (HL), E
-    inc     HL
-    ld      (HL), D
+    ; Entered from the instrumented handler with its own
+    ; return handler in HL, and the caller's HL on the stack.
+__syscall_dispatch:
+    ex      (SP), HL
 
     ; Check:
     ; * That value in A is even.
     bit     #0, A
     jp      nz, #__invalid_syscall
 
-    push    AF
-    call    _status_set_kernel
-    pop     AF
-
-    ; Calculate position of word in syscall table.
+    ; Look up the syscall, leaving its address on the stack.
+    push    HL
     ld      HL, #_syscall_table
-    ld      D, #0
-    ld      E, A
-    add     HL, DE
-    
-    ; Load word into IX.
-    ld      E, (HL)
+    add     A, L
+    ld      L, A
+    adc     A, H
+    sub     L
+    ld      H, A
+    ld      A, (HL)
     inc     HL
-    ld      D, (HL)
-    push    DE
-    pop     IX
-
-    ; Pop registers off stack as they may contain arguments.
-    ; Stack needs to be at same position on entry to the syscall function
-    ; as on entry to the syscall handler.
-    pop     BC
-    pop     DE
-    pop     HL
+    ld      H, (HL)
+    ld      L, A
+    ex      (SP), HL
+
+    ; Count the syscall against the current process.
+    ; The syscall counter is the first field of the descriptor.
+    ld      IX, (_process_current_ptr)
+    inc     0(IX)
+    jr      nz, __syscall_counted
+    inc     1(IX)
+__syscall_counted:
+
+    ; As status_set_kernel, without the call.
+    ld      A, (_current_status)
+    and     A, #STATUS_CLRMASK_KERNEL
+    ld      (_current_status), A
+    out     (STATUS_PORT), A
 
     ; Execute syscall.
     ; Return will return to the syscall return handler.
-    jp      (IX)
+    ret
 
 __syscall_ret:
-    push    AF
-    call    _status_clr_kernel
-    pop     AF
+    ; Interrupts may have been enabled by the syscall.
+    di
+
+    ; As status_clr_kernel, keeping A, which may hold
+    ; an 8-bit return value.
+    ld      B, A
+    ld      A, (_current_status)
+    or      A, #STATUS_SETMASK_KERNEL
+    ld      (_current_status), A
+    out     (STATUS_PORT), A
+    ld      A, B
 
     ; Restore IX.
-    ld      IX, (__syscall_ix)
+    ld      IX, (SYSCALL_IX)
 
     ; Return from syscall.
     ; Re-enable interrupts just before returning.
-    ld      HL, (__syscall_ret_address)
+    ld      HL, (SYSCALL_RET_ADDRESS)
     ei
     jp      (HL)
 
-__syscall_ret_address:
-    .word   0
-__syscall_ix:
-    .word   0
+    .globl  _sysstat_enter
+    .globl  _sysstat_exit
+    .globl  _syscall_handler_stats
+
+    ; Instrumented syscall handler.
+    ;
+    ; Entered instead of the syscall handler when the kernel is
+    ; built with SYSCALL_STATS, by sysstat_init changing the jump
+    ; at the syscall restart. Records each syscall and the time
+    ; spent in it, then dispatches it as usual.
+_syscall_handler_stats:
+    di
+
+    push    HL
+    push    DE
+    push    BC
+    push    AF
+    call    _sysstat_enter
+    pop     AF
+    pop     BC
+    pop     DE
+    pop     HL
+
+    ld      (SYSCALL_IX), IX
+    ex      (SP), HL
+    ld      (SYSCALL_RET_ADDRESS), HL
+    ld      HL, #__syscall_ret_stats
+    jp      __syscall_dispatch
+
+__syscall_ret_stats:
+    di
+
+    ; Keep any return value.
+    push    AF
+    push    DE
+    push    HL
+    call    _sysstat_exit
+    pop     HL
+    pop     DE
+    pop     AF
+
+    jp      __syscall_ret
 
     .globl  _startup_flags
 
@@ -161,6 +264,309 @@ __invalid_syscall:
     ld      (_startup_flags), A
     rst     8
 
+    ; Filesystem syscalls.
+    ;
+    ; These share no state with the interrupt handlers, so they run
+    ; with interrupts enabled. Serial input is still received and
+    ; ticks still counted while they wait for the disk.
+_do_fopen:
+    ei
+    jp      _file_open
+_do_fread:
+    ei
+    jp      _file_read
+_do_fwrite:
+    ei
+    jp      _file_write
+_do_fclose:
+    ei
+    jp      _file_close
+_do_finfo:
+    ei
+    jp      _file_info
+_do_fentries:
+    ei
+    jp      _file_entries
+_do_fentry:
+    ei
+    jp      _file_entry
+_do_fdelete:
+    ei
+    jp      _file_delete
+
+    ; pload reads the program, and copies it between banks, with
+    ; interrupts enabled too. While another bank is selected, an
+    ; interrupt stacks its registers in that bank, below the
+    ; caller's stack pointer. This lies above the program's code
+    ; and data, and below the stack it is given to start with.
+_do_pload:
+    ei
+    jp      _process_load
+_do_fwritev:
+    ei
+    jp      _file_writev
+
+    ; #0: swrite: Write to the terminal or output pipe.
+    ;
+    ; Parameters:
+    ; HL: pointer to bytes.
+    ; DE: number of bytes.
+    ;
+    ; Returns:
+    ; Number of bytes written, in DE.
+    ;
+    ; If the output pipe fills up, the process is blocked and the
+    ; rest of the write is re-issued when it next runs, so the
+    ; caller only sees the syscall return once everything is written.
+    .globl  __swrite_done ; Required for benchmarking.
+_do_swrite:
+    push    HL
+    push    DE
+    call    _terminal_write
+
+    ; Bytes remaining.
+    pop     BC
+    ld      H, B
+    ld      L, C
+    or      A
+    sbc     HL, DE
+    jr      z, __swrite_done
+
+    ; Advance the pointer past the bytes written.
+    ex      (SP), HL
+    add     HL, DE
+    pop     DE
+
+    ; Replace the return to the syscall return handler with the
+    ; original return address, preceded by the original count
+    ; and a continuation which writes the remainder.
+    ex      (SP), HL
+    ld      HL, (SYSCALL_RET_ADDRESS)
+    ex      (SP), HL
+    push    BC
+    push    DE
+    push    HL
+    ld      HL, #__swrite_retry
+    push    HL
+    jp      __yield
+
+__swrite_done:
+    pop     HL
+    ret
+
+__swrite_retry:
+    pop     HL
+    pop     DE
+    ld      A, #0
+    rst     0x30
+
+    ; Return the whole count, rather than the count
+    ; of the part written by the retry.
+    pop     DE
+    ret
+
+    ; #39: swritev: Write several pieces to the terminal or output pipe.
+    ;
+    ; Parameters:
+    ; HL: pointer to array of IOVec_T.
+    ; DE: number of pieces.
+    ;
+    ; Returns:
+    ; Number of pieces written, in DE.
+    ;
+    ; As swrite, if the output fills up the process is blocked and
+    ; the rest of the write is re-issued when it next runs.
+_do_swritev:
+    push    HL
+    push    DE
+    call    _terminal_writev
+
+    ; Pieces remaining.
+    pop     BC
+    ld      H, B
+    ld      L, C
+    or      A
+    sbc     HL, DE
+    jr      z, __swritev_done
+
+    ; Advance the pointer past the pieces written.
+    ; Each IOVec_T is four bytes.
+    ex      DE, HL
+    add     HL, HL
+    add     HL, HL
+    ex      DE, HL
+    ex      (SP), HL
+    add     HL, DE
+    pop     DE
+
+    ex      (SP), HL
+    ld      HL, (SYSCALL_RET_ADDRESS)
+    ex      (SP), HL
+    push    BC
+    push    DE
+    push    HL
+    ld      HL, #__swritev_retry
+    push    HL
+    jp      __yield
+
+__swritev_done:
+    pop     HL
+    ret
+
+__swritev_retry:
+    pop     HL
+    pop     DE
+    ld      A, #78
+    rst     0x30
+    pop     DE
+    ret
+
+    ; #1: sread: Read a byte from the terminal or input pipe.
+    ;
+    ; Parameters:
+    ; None.
+    ;
+    ; Returns:
+    ; Byte, -1 if none is available from the terminal, or
+    ; -2 at the end of the input pipe, in DE.
+    ;
+    ; If the input pipe is empty, or the terminal is empty in
+    ; blocking mode, the process is blocked and the read is
+    ; re-issued when it next runs.
+_do_sread:
+    call    _terminal_get
+
+    ; PIPE_BLOCKED or TERMINAL_BLOCKED?
+    ld      A, E
+    cp      #0xfd
+    ret     nz
+    ld      A, D
+    inc     A
+    ret     nz
+
+    pop     HL
+    ld      HL, (SYSCALL_RET_ADDRESS)
+    push    HL
+    ld      HL, #__sread_retry
+    push    HL
+    jp      __yield
+
+__sread_retry:
+    ld      A, #2
+    rst     0x30
+    ret
+
+    ; #37: readline: Read a line from the terminal.
+    ;
+    ; Parameters:
+    ; HL: buffer.
+    ; DE: size of buffer.
+    ;
+    ; Returns:
+    ; Length of the line, in DE.
+    ;
+    ; Until the line is finished the process is blocked, and the
+    ; read is re-issued each time it is woken.
+_do_readline:
+    push    HL
+    push    DE
+    call    _terminal_readline
+
+    ; TERMINAL_BLOCKED?
+    ld      A, E
+    cp      #0xfd
+    jr      nz, __readline_done
+    ld      A, D
+    inc     A
+    jr      nz, __readline_done
+
+    pop     DE
+    pop     HL
+    pop     BC
+    ld      BC, (SYSCALL_RET_ADDRESS)
+    push    BC
+    push    DE
+    push    HL
+    ld      HL, #__readline_retry
+    push    HL
+    jp      __yield
+
+__readline_done:
+    pop     HL
+    pop     HL
+    ret
+
+__readline_retry:
+    pop     HL
+    pop     DE
+    ld      A, #74
+    rst     0x30
+    ret
+
+    ; #38: sreadn: Read several bytes from the terminal or input pipe.
+    ;
+    ; Parameters:
+    ; HL: buffer.
+    ; DE: size of buffer.
+    ; Stack: minimum number of bytes to wait for.
+    ;
+    ; Returns:
+    ; Number of bytes read, or -2 at the end of the input pipe, in DE.
+    ;
+    ; Until enough bytes are waiting the process is blocked, and the
+    ; read is re-issued each time it is woken.
+_do_sreadn:
+    ; Take the minimum from under the return to the syscall
+    ; return handler, which terminal_readn would otherwise see.
+    pop     BC
+    ex      (SP), HL
+    ld      (__sreadn_min), HL
+    pop     HL
+    push    BC
+
+    push    HL
+    push    DE
+    ld      BC, (__sreadn_min)
+    push    BC
+    call    _terminal_readn
+
+    ; TERMINAL_BLOCKED or PIPE_BLOCKED?
+    ld      A, E
+    cp      #0xfd
+    jr      nz, __sreadn_done
+    ld      A, D
+    inc     A
+    jr      nz, __sreadn_done
+
+    pop     DE
+    pop     HL
+    pop     BC
+    ld      BC, (SYSCALL_RET_ADDRESS)
+    push    BC
+    ld      BC, (__sreadn_min)
+    push    BC
+    push    DE
+    push    HL
+    ld      HL, #__sreadn_retry
+    push    HL
+    jp      __yield
+
+__sreadn_done:
+    pop     HL
+    pop     HL
+    ret
+
+    ; The minimum is left on the stack for the syscall.
+__sreadn_retry:
+    pop     HL
+    pop     DE
+    ld      A, #76
+    rst     0x30
+    ret
+
+__sreadn_min:
+    .word   0
+
     .globl  _disk_info
 
     ; #8: dinfo: Get information about disk.
@@ -197,18 +603,132 @@ _do_pexit:
     call    _process_exit
 
     ; This syscall doesn't return.
-    push    AF
-    call    _status_clr_kernel
-    pop     AF
-    ei
+    ; Give up the rest of the time slice, "returning" to a loop
+    ; which is only reached if there is no other task to run.
+    pop     HL
+    ld      HL, #__pexit_loop
+    push    HL
+    jp      __yield
 
 __pexit_loop:
+    ld      A, #46
+    rst     0x30
     jp      __pexit_loop
 
+    ; #22: psleep: Sleep for a number of ticks.
+    ;
+    ; Parameters:
+    ; HL: number of ticks.
+    ;
+    ; Returns:
+    ; Tick count at which the process was due to wake, in DE.
+    ;
+    ; The process is blocked, and the syscall only returns once the
+    ; tick count has reached the wake time.
+_do_psleep:
+    ; Zero ticks does not block.
+    ld      A, H
+    or      L
+    jp      z, _scheduler_sleep
+
+    call    _scheduler_sleep
+
+    ; Replace the return to the syscall return handler with the
+    ; original return address, preceded by the wake time and a
+    ; continuation which waits for it.
+    pop     HL
+    ld      HL, (SYSCALL_RET_ADDRESS)
+    push    HL
+    push    DE
+    ld      HL, #__psleep_wait
+    push    HL
+    jp      __yield
+
+    ; Reached once woken, or if there was no other task to run,
+    ; in which case the rest of the time slice is given up again.
+__psleep_wait:
+    pop     DE
+    push    DE
+    ld      HL, (_scheduler_ticks)
+    or      A
+    sbc     HL, DE
+    bit     #7, H
+    jr      z, __psleep_done
+
+    ld      A, #46
+    rst     0x30
+    jr      __psleep_wait
+
+__psleep_done:
+    pop     DE
+    ret
+
+    ; #35: pclone: Create a copy of the current process.
+    ;
+    ; Parameters:
+    ; None.
+    ;
+    ; Returns:
+    ; Process ID of the copy to the caller, 0 to the copy,
+    ; or <0 if error, in DE.
+_do_pclone:
+    ; Copying the bank takes the best part of half a second,
+    ; so it is done with interrupts enabled, as pload is.
+    ; process_clone disables them again once it has copied it.
+    ei
+
+    ; Take the return to the syscall return handler off the
+    ; stack, leaving SP as the caller will see it.
+    pop     BC
+    ld      HL, #0
+    add     HL, SP
+
+    ; process_clone(sp, pc, ix). ix is passed on the
+    ; stack, and cleaned up by process_clone.
+    ld      DE, (SYSCALL_IX)
+    push    DE
+    push    BC
+    ld      DE, (SYSCALL_RET_ADDRESS)
+    jp      _process_clone
+
+    ; #23: pyield: Give up the rest of the current time slice.
+    ;
+    ; Parameters:
+    ; None.
+    ;
+    ; Returns:
+    ; Nothing.
+_do_pyield:
+    ; Replace the return to the syscall return handler with
+    ; the original return address, so the stack looks as if
+    ; the process had been interrupted at that point.
+    pop     HL
+    ld      HL, (SYSCALL_RET_ADDRESS)
+    push    HL
+
+__yield:
+    ; Restore IX so it is saved with the process context.
+    ld      IX, (SYSCALL_IX)
+
+    call    _status_clr_kernel
+
+    ; Enter the timer handler's context switch path.
+    ; It expects the system register set to be active, as on
+    ; entry to the interrupt handler, and interrupts disabled.
+    exx
+    ex      AF, AF'
+    jp      __timer_handler_switch
+
 _sysinfo:
     .word   _kernel_version
 __sysinfo_numbanks:
     .word   #0
+__sysinfo_ticks:
+    .word   _scheduler_ticks
+__sysinfo_memory:
+    .word   _memory_stats
+__sysinfo_terminal:
+    .word   _terminal_stats
 
     .globl  _kernel_version
 _kernel_version:
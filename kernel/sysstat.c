@@ -0,0 +1,80 @@
+#include <string.h>
+
+#include <include/sysstat.h>
+
+extern uint16_t scheduler_ticks;
+
+static uint16_t sysstat_ticks(void)
+{
+    return scheduler_ticks;
+}
+
+/* Set by sysstat_init, as the kernel has no start-up
+ * code to copy initialised data into place. */
+uint16_t (*sysstat_clock)(void);
+
+#ifdef SYSCALL_STATS
+SysStat_T sysstat_table[SYSSTAT_MAX];
+
+/* Syscall being timed, and when it started. */
+uint8_t sysstat_current;
+uint16_t sysstat_start;
+
+#ifdef Z80
+/* Address of the jump at the syscall restart. */
+#define SYSCALL_VECTOR 0x0031
+
+void syscall_handler_stats(void);
+#endif
+#endif
+
+void sysstat_init(void)
+{
+    sysstat_clock = sysstat_ticks;
+
+#ifdef SYSCALL_STATS
+    memset(sysstat_table, 0, sizeof(sysstat_table));
+    sysstat_current = SYSSTAT_MAX;
+
+#ifdef Z80
+    *(uint16_t *)SYSCALL_VECTOR = (uint16_t)syscall_handler_stats;
+#endif
+#endif
+}
+
+void sysstat_enter(uint8_t offset)
+{
+#ifdef SYSCALL_STATS
+    uint8_t i = offset >> 1;
+    if (i >= SYSSTAT_MAX) return;
+
+    sysstat_table[i].count++;
+    sysstat_current = i;
+    sysstat_start = sysstat_clock();
+#else
+    offset;
+#endif
+}
+
+void sysstat_exit(void)
+{
+#ifdef SYSCALL_STATS
+    if (sysstat_current >= SYSSTAT_MAX) return;
+
+    sysstat_table[sysstat_current].time += sysstat_clock() - sysstat_start;
+    sysstat_current = SYSSTAT_MAX;
+#endif
+}
+
+size_t sysstat_read(SysStat_T * buf, size_t max)
+{
+#ifdef SYSCALL_STATS
+    if (max > SYSSTAT_MAX) max = SYSSTAT_MAX;
+
+    memcpy(buf, sysstat_table, max * sizeof(SysStat_T));
+    return max;
+#else
+    buf; max;
+    return 0;
+#endif
+}
@@ -1,28 +1,212 @@
+#include <string.h>
+
 #include <include/terminal.h>
 #include <include/process.h>
 #include <include/bits.h>
 #include <include/signal.h>
+#include <include/pipe.h>
+#include <include/scheduler.h>
 
 #define ASCII_CANCEL 0x18
+#define ASCII_XON 0x11
+#define ASCII_XOFF 0x13
+#define ASCII_BACKSPACE 0x08
+#define ASCII_DELETE 0x7f
+
+/* Each process has its own input buffer, so that input typed
+ * for one process is not read by another. Received bytes go to
+ * the buffer of the process with the active terminal. */
+#define TERMINAL_BUF_SIZE 32
+
+typedef struct _TerminalBuf_T
+{
+    char data[TERMINAL_BUF_SIZE];
+    uint8_t head;
+    uint8_t tail;
+
+    /* Process to give the active terminal back to
+     * when this process exits. */
+    int8_t return_to;
+
+    /* Number of bytes a blocked reader is waiting for. */
+    uint8_t want;
+
+    /* Length of the line readline has read so far from an input
+     * pipe, and the line ending which ended the last one, or 0. */
+    uint8_t line_len;
+    char line_end;
+} TerminalBuf_T;
+
+TerminalBuf_T terminal_bufs[PROCS_MAX];
+
+/* Process with the active terminal, or TERMINAL_NONE. */
+int8_t terminal_active;
+
+/* The sender is asked to stop once the active terminal's buffer
+ * reaches the high-water mark, leaving room for bytes already on
+ * their way, and to carry on once it has drained to the low-water mark. */
+#define TERMINAL_RX_HIGH 24
+#define TERMINAL_RX_LOW 8
+
+/* Set while the sender has been asked to stop. */
+bool terminal_throttled;
+
+/* Set if the sender was stopped with XOFF, rather than with RTS. */
+bool terminal_xoff;
 
-struct _TerminalBuf
+TerminalStats_T terminal_stats;
+
+static void terminal_rx_flow(void);
+
+/* Set if a reader is blocked waiting for input. */
+bool terminal_rx_waiting;
+
+/* Line being edited by readline, for the process with the active
+ * terminal. Only one line is edited at a time, as only the active
+ * terminal receives input. */
+struct _TerminalLine
+{
+    char data[TERMINAL_LINE_MAX];
+    uint8_t len;
+
+    /* Process the line belongs to, or TERMINAL_NONE. */
+    int8_t pid;
+
+    /* Set once the line has been ended with return. */
+    bool done;
+} terminal_line;
+
+/* Bytes waiting to be transmitted. Filled by terminal_write and
+ * drained by the transmit interrupt, one byte per interrupt.
+ * One slot is left empty to tell a full buffer from an empty one. */
+struct _TerminalTxBuf
 {
     char data[256];
     uint8_t head;
     uint8_t tail;
-} terminal_buf;
+
+    /* XON or XOFF waiting to be sent, or 0. */
+    char flow;
+
+    /* Set while the transmit interrupt is enabled. */
+    bool busy;
+
+    /* Set if a writer is blocked waiting for space. */
+    bool waiting;
+} terminal_tx;
+
+/* #6850 control register. Receive interrupt enabled, 8 data bits,
+ * 1 stop bit, clock divided by 64, with bits 5 and 6 controlling
+ * RTS and the transmit interrupt. RTS can only be de-asserted with
+ * the transmit interrupt disabled. */
+#define ACIA_CONTROL 0x96
+#define ACIA_CONTROL_TX_INT 0x20
+#define ACIA_CONTROL_RTS_HIGH 0x40
+
+void driver_6850_control(uint8_t control);
+
+/* Writers are woken once fewer than this many bytes are waiting,
+ * rather than for every byte sent, so that they are not
+ * rescheduled on every interrupt. */
+#define TERMINAL_TX_WAKE 128
 
 void terminal_init(void)
 {
-    terminal_buf.head = 0;
-    terminal_buf.tail = 0;
+    for (int i = 0; i < PROCS_MAX; i++)
+    {
+        terminal_bufs[i].head = 0;
+        terminal_bufs[i].tail = 0;
+        terminal_bufs[i].return_to = TERMINAL_NONE;
+        terminal_bufs[i].want = 1;
+        terminal_bufs[i].line_len = 0;
+        terminal_bufs[i].line_end = 0;
+    }
+
+    terminal_active = TERMINAL_NONE;
+    terminal_rx_waiting = false;
+    terminal_throttled = false;
+    terminal_xoff = false;
+
+    terminal_stats.dropped = 0;
+    terminal_stats.overruns = 0;
+    terminal_stats.throttled = 0;
+
+    terminal_line.len = 0;
+    terminal_line.pid = TERMINAL_NONE;
+    terminal_line.done = false;
+
+    terminal_tx.head = 0;
+    terminal_tx.tail = 0;
+    terminal_tx.flow = 0;
+    terminal_tx.busy = false;
+    terminal_tx.waiting = false;
+
+#ifdef DEBUG
+    terminal_set_active(0);
+#endif
+}
+
+/* Returns true if the process has not exited. */
+static bool terminal_alive(int pid)
+{
+    TaskState_T state = scheduler_state(pid);
+    return state != TASK_FINISHED && state != TASK_FREE;
 }
 
-/* Gets terminal status of the current process. */
-termstatus_t terminal_status(void)
+int terminal_set_active(int pid)
 {
-    ProcessDescriptor_T * p = process_current();
-    return p->termstatus;
+    if (pid < 0 || pid >= PROCS_MAX) return E_NOTERMINAL;
+    if (process_info(pid)->base_address == 0x0000) return E_NOTERMINAL;
+
+    int previous = terminal_active;
+    if (previous == pid) return previous;
+
+    if (previous != TERMINAL_NONE)
+    {
+        BIT_CLR(process_descriptor(previous)->termstatus, TERMSTATUS_ACTIVE);
+    }
+
+    BIT_SET(process_descriptor(pid)->termstatus, TERMSTATUS_ACTIVE);
+    terminal_bufs[pid].return_to = (int8_t)previous;
+    terminal_active = (int8_t)pid;
+
+    /* The new owner's buffer may have a different amount of room. */
+    terminal_rx_flow();
+
+    /* The new owner may be waiting in readline for its turn. */
+    if (terminal_rx_waiting)
+    {
+        terminal_rx_waiting = false;
+        scheduler_broadcast_event(EVENT_TERMINAL_RX, -1);
+    }
+
+    return previous;
+}
+
+int terminal_active_pid(void)
+{
+    return terminal_active;
+}
+
+void terminal_exit(int pid)
+{
+    TerminalBuf_T * buf = &terminal_bufs[pid];
+    buf->head = 0;
+    buf->tail = 0;
+    buf->line_len = 0;
+    buf->line_end = 0;
+
+    if (terminal_active != pid) return;
+
+    BIT_CLR(process_descriptor(pid)->termstatus, TERMSTATUS_ACTIVE);
+    terminal_active = TERMINAL_NONE;
+    terminal_rx_flow();
+
+    /* Give the terminal back, e.g. to the shell which ran this process. */
+    if (buf->return_to != TERMINAL_NONE && terminal_alive(buf->return_to))
+    {
+        terminal_set_active(buf->return_to);
+    }
 }
 
 /* Sets terminal mode of the current process. */
@@ -30,7 +214,7 @@ void terminal_set_mode(int mode)
 {
     ProcessDescriptor_T * p = process_current();
 
-    if (mode)
+    if (mode & TERMINAL_MODE_BINARY)
     {
         BIT_SET(p->termstatus, TERMSTATUS_MODE_BINARY);
     }
@@ -38,26 +222,433 @@ void terminal_set_mode(int mode)
     {
         BIT_CLR(p->termstatus, TERMSTATUS_MODE_BINARY);
     }
+
+    if (mode & TERMINAL_MODE_BLOCKING)
+    {
+        BIT_SET(p->termstatus, TERMSTATUS_MODE_BLOCKING);
+    }
+    else
+    {
+        BIT_CLR(p->termstatus, TERMSTATUS_MODE_BLOCKING);
+    }
+
+    if (mode & TERMINAL_MODE_XONXOFF)
+    {
+        BIT_SET(p->termstatus, TERMSTATUS_MODE_XONXOFF);
+    }
+    else
+    {
+        BIT_CLR(p->termstatus, TERMSTATUS_MODE_XONXOFF);
+    }
+}
+
+void driver_6850_tx(const char * s, size_t count);
+
+/* Sets RTS and the transmit interrupt to match the receive and
+ * transmit buffers. Output comes first: as RTS can only be
+ * de-asserted with the transmit interrupt disabled, the sender
+ * is only stopped once everything queued has been sent. */
+static void terminal_control_update(void)
+{
+    uint8_t control = ACIA_CONTROL;
+
+    if (terminal_tx.busy) control |= ACIA_CONTROL_TX_INT;
+    else if (terminal_throttled && !terminal_xoff) control |= ACIA_CONTROL_RTS_HIGH;
+
+    driver_6850_control(control);
+}
+
+/* Queues as many bytes as fit in the transmit buffer, and starts
+ * the transmitter if it is idle. If not all of them fit, the
+ * current process is blocked until the buffer drains.
+ * Returns the number of bytes queued. */
+static size_t terminal_tx_queue(const char * s, size_t count)
+{
+    size_t n = 0;
+
+    while (n < count && (uint8_t)(terminal_tx.head + 1) != terminal_tx.tail)
+    {
+        terminal_tx.data[terminal_tx.head++] = s[n++];
+    }
+
+    if (n != 0 && !terminal_tx.busy)
+    {
+        terminal_tx.busy = true;
+        terminal_control_update();
+    }
+
+    if (n < count)
+    {
+        terminal_tx.waiting = true;
+        scheduler_block_current(EVENT_TERMINAL_TX);
+    }
+
+    return n;
+}
+
+/* Queues a byte for transmission, dropping it if the buffer
+ * is full. For echoing input from the receive interrupt,
+ * which cannot block. */
+static void terminal_tx_put(char c)
+{
+    if ((uint8_t)(terminal_tx.head + 1) == terminal_tx.tail) return;
+
+    terminal_tx.data[terminal_tx.head++] = c;
+
+    if (!terminal_tx.busy)
+    {
+        terminal_tx.busy = true;
+        terminal_control_update();
+    }
+}
+
+size_t terminal_write(const char * s, size_t count)
+{
+    ProcessDescriptor_T * p = process_current();
+
+    if (p->pipe_out != PIPE_NONE) count = pipe_write(p->pipe_out, s, count);
+
+    /* Until the first process is scheduled nothing can block,
+     * so wait for each byte to go out instead. */
+    else if (scheduler_current() < 0) driver_6850_tx(s, count);
+
+    else count = terminal_tx_queue(s, count);
+
+    p->stats.bytes_written += count;
+    return count;
+}
+
+size_t terminal_writev(IOVec_T * iov, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t n = terminal_write(iov[i].ptr, iov[i].len);
+
+        /* Blocked. Leave the rest of this piece for the retry. */
+        if (n < iov[i].len)
+        {
+            iov[i].ptr += n;
+            iov[i].len -= n;
+            return i;
+        }
+    }
+
+    return count;
+}
+
+int terminal_tx_next(void)
+{
+    /* Flow control goes ahead of anything queued. */
+    if (terminal_tx.flow != 0)
+    {
+        char f = terminal_tx.flow;
+        terminal_tx.flow = 0;
+        return (uint8_t)f;
+    }
+
+    if (terminal_tx.head == terminal_tx.tail)
+    {
+        terminal_tx.busy = false;
+        terminal_control_update();
+        return -1;
+    }
+
+    char c = terminal_tx.data[terminal_tx.tail++];
+
+    uint8_t used = terminal_tx.head - terminal_tx.tail;
+    if (terminal_tx.waiting && used < TERMINAL_TX_WAKE)
+    {
+        terminal_tx.waiting = false;
+        scheduler_broadcast_event(EVENT_TERMINAL_TX, -1);
+    }
+
+    return (uint8_t)c;
+}
+
+/* Sends XON or XOFF ahead of any queued output, as there
+ * is little room left for input once the sender is asked
+ * to stop. XON cancels an XOFF which has not yet gone. */
+static void terminal_tx_flow(char c)
+{
+    if (terminal_tx.flow != 0) terminal_tx.flow = 0;
+    else terminal_tx.flow = c;
+
+    if (!terminal_tx.busy)
+    {
+        terminal_tx.busy = true;
+        terminal_control_update();
+    }
+}
+
+/* Asks the sender to stop or carry on, according to how full the
+ * active terminal's buffer is. In binary mode with XON/XOFF selected
+ * the sender is sent XOFF and XON, otherwise RTS is de-asserted. */
+static void terminal_rx_flow(void)
+{
+    uint8_t level = 0;
+    if (terminal_active != TERMINAL_NONE)
+    {
+        TerminalBuf_T * buf = &terminal_bufs[terminal_active];
+        level = buf->head - buf->tail;
+    }
+
+    if (!terminal_throttled && level >= TERMINAL_RX_HIGH)
+    {
+        termstatus_t status = process_descriptor(terminal_active)->termstatus;
+
+        terminal_throttled = true;
+        terminal_xoff = BIT_IS_SET(status, TERMSTATUS_MODE_BINARY) && BIT_IS_SET(status, TERMSTATUS_MODE_XONXOFF);
+        terminal_stats.throttled++;
+
+        if (terminal_xoff) terminal_tx_flow(ASCII_XOFF);
+        else terminal_control_update();
+    }
+    else if (terminal_throttled && level <= TERMINAL_RX_LOW)
+    {
+        terminal_throttled = false;
+
+        if (terminal_xoff) terminal_tx_flow(ASCII_XON);
+        else terminal_control_update();
+    }
+}
+
+/* Adds a byte to the line being edited for a process. In cooked
+ * mode the byte is echoed, and backspace removes the last byte.
+ * In binary mode the line is collected raw. Either way, return
+ * ends the line. */
+static void terminal_line_edit(int pid, char c, bool cooked)
+{
+    if (terminal_line.pid != pid)
+    {
+        terminal_line.pid = (int8_t)pid;
+        terminal_line.len = 0;
+        terminal_line.done = false;
+    }
+
+    if (c == '\r' || c == '\n')
+    {
+        terminal_line.done = true;
+        if (cooked)
+        {
+            terminal_tx_put('\r');
+            terminal_tx_put('\n');
+        }
+    }
+    else if (cooked && (c == ASCII_BACKSPACE || c == ASCII_DELETE))
+    {
+        if (terminal_line.len == 0) return;
+
+        terminal_line.len--;
+        terminal_tx_put(ASCII_BACKSPACE);
+        terminal_tx_put(' ');
+        terminal_tx_put(ASCII_BACKSPACE);
+    }
+    else if (terminal_line.len < TERMINAL_LINE_MAX - 1)
+    {
+        terminal_line.data[terminal_line.len++] = c;
+        if (cooked) terminal_tx_put(c);
+    }
 }
 
 void terminal_put(char c)
 {
+    /* Nobody to receive it. */
+    if (terminal_active == TERMINAL_NONE) return;
+
+    ProcessDescriptor_T * p = process_descriptor(terminal_active);
+
     /* If the character is the CANCEL byte and the terminal is
      * in interactive mode, then trigger SIG_CANCEL.
      */
-    if (c == ASCII_CANCEL && BIT_IS_CLR(terminal_status(), TERMSTATUS_MODE_BINARY))
+    if (c == ASCII_CANCEL && BIT_IS_CLR(p->termstatus, TERMSTATUS_MODE_BINARY))
     {
-        signal_set(SIGSTAT_CANCEL);
+        BIT_SET(p->sigstatus, SIGSTAT_CANCEL);
+
+        /* The handler will not return to readline. */
+        BIT_CLR(p->termstatus, TERMSTATUS_READLINE);
+        if (terminal_line.pid == terminal_active) terminal_line.pid = TERMINAL_NONE;
+    }
+    else if (BIT_IS_SET(p->termstatus, TERMSTATUS_READLINE) && BIT_IS_CLR(p->termstatus, TERMSTATUS_MODE_BINARY)
+        && !(terminal_line.pid == terminal_active && terminal_line.done))
+    {
+        /* Edit the line straight away, so that the
+         * reader is only woken once it is finished. */
+        terminal_line_edit(terminal_active, c, true);
+        if (!terminal_line.done) return;
     }
     else
     {
-        terminal_buf.data[terminal_buf.head++] = c;
+        /* Bytes typed after a finished line, before the reader has
+         * taken it, are kept for the next line. */
+        TerminalBuf_T * buf = &terminal_bufs[terminal_active];
+
+        /* Drop the byte if the buffer is full. */
+        if ((uint8_t)(buf->head - buf->tail) == TERMINAL_BUF_SIZE)
+        {
+            terminal_stats.dropped++;
+            return;
+        }
+
+        buf->data[buf->head++ & (TERMINAL_BUF_SIZE - 1)] = c;
+        BIT_SET(p->termstatus, TERMSTATUS_AVAILABLE);
+
+        terminal_rx_flow();
+
+        /* Let a bulk reader sleep until it has enough. */
+        if ((uint8_t)(buf->head - buf->tail) < buf->want) return;
+    }
+
+    /* Wake readers for the byte, or so that a
+     * blocked process can handle the signal. */
+    if (terminal_rx_waiting)
+    {
+        terminal_rx_waiting = false;
+        scheduler_broadcast_event(EVENT_TERMINAL_RX, -1);
     }
 }
 
 int terminal_get(void)
 {
-    if (terminal_buf.head == terminal_buf.tail) return -1;
-    
-    return (int)terminal_buf.data[terminal_buf.tail++];
+    ProcessDescriptor_T * p = process_current();
+    if (p->pipe_in != PIPE_NONE) return pipe_read(p->pipe_in);
+
+    TerminalBuf_T * buf = &terminal_bufs[scheduler_current_pid()];
+
+    if (buf->head == buf->tail)
+    {
+        if (BIT_IS_CLR(p->termstatus, TERMSTATUS_MODE_BLOCKING)) return -1;
+
+        buf->want = 1;
+        terminal_rx_waiting = true;
+        scheduler_block_current(EVENT_TERMINAL_RX);
+        return TERMINAL_BLOCKED;
+    }
+
+    char c = buf->data[buf->tail++ & (TERMINAL_BUF_SIZE - 1)];
+    if (buf->head == buf->tail) BIT_CLR(p->termstatus, TERMSTATUS_AVAILABLE);
+
+    if (terminal_throttled) terminal_rx_flow();
+
+    return (uint8_t)c;
+}
+
+int terminal_readn(char * buf, size_t max, size_t min)
+{
+    ProcessDescriptor_T * p = process_current();
+
+    if (max == 0) return 0;
+    if (p->pipe_in != PIPE_NONE) return pipe_readn(p->pipe_in, buf, max);
+
+    TerminalBuf_T * in = &terminal_bufs[scheduler_current_pid()];
+    uint8_t n = in->head - in->tail;
+
+    /* The sender is stopped at the high-water mark,
+     * so more than that might never arrive. */
+    if (min > max) min = max;
+    if (min > TERMINAL_RX_HIGH) min = TERMINAL_RX_HIGH;
+
+    if (n < min)
+    {
+        in->want = (uint8_t)min;
+        terminal_rx_waiting = true;
+        scheduler_block_current(EVENT_TERMINAL_RX);
+        return TERMINAL_BLOCKED;
+    }
+
+    if (n > max) n = (uint8_t)max;
+
+    for (uint8_t i = 0; i < n; i++)
+    {
+        buf[i] = in->data[in->tail++ & (TERMINAL_BUF_SIZE - 1)];
+    }
+    if (in->head == in->tail) BIT_CLR(p->termstatus, TERMSTATUS_AVAILABLE);
+
+    if (terminal_throttled) terminal_rx_flow();
+
+    return n;
+}
+
+/* Reads a line from an input pipe, raw, as in binary mode. The line
+ * is built up in buf, which the retry passes again, if the pipe runs
+ * dry part way through. A line feed straight after a carriage return,
+ * or the other way round, ends the same line rather than another. */
+static int terminal_readline_pipe(int pipe, char * buf, size_t max)
+{
+    TerminalBuf_T * in = &terminal_bufs[scheduler_current_pid()];
+
+    while (true)
+    {
+        int c = pipe_read(pipe);
+        if (c == PIPE_BLOCKED) return TERMINAL_BLOCKED;
+
+        if (c == PIPE_EOF)
+        {
+            /* A last line without an ending. */
+            if (in->line_len == 0) return PIPE_EOF;
+            break;
+        }
+
+        if (c == '\r' || c == '\n')
+        {
+            bool pair = in->line_len == 0 && in->line_end != 0 && in->line_end != c;
+
+            in->line_end = pair ? 0 : (char)c;
+            if (pair) continue;
+            break;
+        }
+
+        in->line_end = 0;
+        if (in->line_len < max - 1) buf[in->line_len++] = (char)c;
+    }
+
+    int n = in->line_len;
+    buf[n] = '\0';
+    in->line_len = 0;
+
+    return n;
+}
+
+int terminal_readline(char * buf, size_t max)
+{
+    int pid = scheduler_current_pid();
+    ProcessDescriptor_T * p = process_current();
+
+    if (max == 0) return 0;
+    if (p->pipe_in != PIPE_NONE) return terminal_readline_pipe(p->pipe_in, buf, max);
+
+    /* Only the active terminal edits a line. */
+    if (pid == terminal_active)
+    {
+        bool cooked = BIT_IS_CLR(p->termstatus, TERMSTATUS_MODE_BINARY);
+
+        /* Take any bytes typed before readline was called. */
+        TerminalBuf_T * in = &terminal_bufs[pid];
+        while (!(terminal_line.pid == pid && terminal_line.done) && in->head != in->tail)
+        {
+            terminal_line_edit(pid, in->data[in->tail++ & (TERMINAL_BUF_SIZE - 1)], cooked);
+        }
+        if (in->head == in->tail) BIT_CLR(p->termstatus, TERMSTATUS_AVAILABLE);
+        if (terminal_throttled) terminal_rx_flow();
+
+        if (terminal_line.pid == pid && terminal_line.done)
+        {
+            size_t n = terminal_line.len;
+            if (n > max - 1) n = max - 1;
+
+            memcpy(buf, terminal_line.data, n);
+            buf[n] = '\0';
+
+            terminal_line.pid = TERMINAL_NONE;
+            BIT_CLR(p->termstatus, TERMSTATUS_READLINE);
+
+            return (int)n;
+        }
+    }
+
+    BIT_SET(p->termstatus, TERMSTATUS_READLINE);
+    terminal_bufs[pid].want = 1;
+    terminal_rx_waiting = true;
+    scheduler_block_current(EVENT_TERMINAL_RX);
+
+    return TERMINAL_BLOCKED;
 }
@@ -0,0 +1,72 @@
+#include <string.h>
+
+#include <include/trace.h>
+
+#define TRACE_SIZE 64
+
+#ifdef SCHED_TRACE
+extern uint16_t scheduler_ticks;
+
+TraceEntry_T trace_buf[TRACE_SIZE];
+
+/* Index of the next entry to write. */
+uint8_t trace_head;
+
+/* Number of valid entries in the buffer. */
+uint8_t trace_count;
+
+/* Number of entries overwritten before being drained. */
+uint16_t trace_dropped;
+#endif
+
+void trace_init(void)
+{
+#ifdef SCHED_TRACE
+    trace_head = 0;
+    trace_count = 0;
+    trace_dropped = 0;
+#endif
+}
+
+void trace_record(TraceReason_T reason, int8_t from, int8_t to)
+{
+#ifdef SCHED_TRACE
+    TraceEntry_T * e = &trace_buf[trace_head];
+    e->tick = scheduler_ticks;
+    e->from = from;
+    e->to = to;
+    e->reason = reason;
+
+    trace_head++;
+    if (trace_head >= TRACE_SIZE) trace_head = 0;
+
+    if (trace_count < TRACE_SIZE) trace_count++;
+    else trace_dropped++;
+#else
+    reason; from; to;
+#endif
+}
+
+size_t trace_drain(TraceEntry_T * buf, size_t max)
+{
+#ifdef SCHED_TRACE
+    size_t n = 0;
+
+    while (trace_count > 0 && n < max)
+    {
+        /* Oldest entry is trace_count entries behind the head. */
+        uint8_t tail = trace_head + TRACE_SIZE - trace_count;
+        if (tail >= TRACE_SIZE) tail -= TRACE_SIZE;
+
+        memcpy(&buf[n], &trace_buf[tail], sizeof(TraceEntry_T));
+
+        trace_count--;
+        n++;
+    }
+
+    return n;
+#else
+    buf; max;
+    return 0;
+#endif
+}
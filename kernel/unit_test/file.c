@@ -543,3 +543,30 @@ int test_file_stress_test()
 
     return 0;
 }
+
+/* Given several pieces, ensure that file_writev writes
+ * them one after another.
+ */
+int test_file_writev()
+{
+    mock_drive_init();
+
+    int fd = file_open("test.txt", FMODE_WRITE);
+    ASSERT(fd == 0);
+
+    IOVec_T iov[3] = {
+        { "Hello", 5 },
+        { ", ", 2 },
+        { "world", 5 }
+    };
+    ASSERT(file_writev(iov, 3, fd) == 12);
+    file_close(fd);
+
+    char buf[32];
+    fd = file_open("test.txt", FMODE_READ);
+    ASSERT(file_read(buf, sizeof(buf), fd) == 12);
+    ASSERT(memcmp(buf, "Hello, world", 12) == 0);
+    file_close(fd);
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include <string.h>
+
+#include <include/file.h>
+#include <include/lz.h>
+
+#include <syscall.h>
+#include <test.h>
+#include <disk.h>
+
+extern FileDescriptor_T fdtable[FILE_LIMIT];
+extern DiskInfo_T disk_info;
+extern uint32_t current_cache_sector;
+
+/* Puts a stream of less than one sector in a file and
+ * starts decoding from it. */
+static void lz_test_open(const char * stream, size_t size)
+{
+    char sector[512];
+
+    mock_drive_init();
+
+    memset(sector, 0, 512);
+    memcpy(sector, stream, size);
+    disk_write(sector, disk_info.data_region);
+
+    /* Each test reuses the same sector, so drop any cached copy. */
+    current_cache_sector = 0xffffffff;
+
+    FileDescriptor_T * file = &fdtable[0];
+    file->mode = FMODE_READ;
+    file->current_cluster = 2;
+    file->sector = 0;
+    file->fpos_within_sector = 0;
+    file->fpos = 0;
+    file->size = size;
+
+    lz_begin(0);
+}
+
+/* A stream of only literals is copied as is. */
+int test_lz_literals()
+{
+    const char stream[] = { 0x50, 'H', 'e', 'l', 'l', 'o' };
+    lz_test_open(stream, sizeof(stream));
+
+    char out[8];
+    memset(out, '!', 8);
+
+    ASSERT_EQUAL_INT(0, lz_decode(out, 5));
+    ASSERT(memcmp(out, "Hello!", 6) == 0);
+
+    return 0;
+}
+
+/* A match shorter than its offset away repeats the last bytes. */
+int test_lz_overlapping_match()
+{
+    /* "ab", then 8 bytes from 2 back. */
+    const char stream[] = { 0x24, 'a', 'b', 0x02, 0x00 };
+    lz_test_open(stream, sizeof(stream));
+
+    char out[11];
+    out[10] = '\0';
+
+    ASSERT_EQUAL_INT(0, lz_decode(out, 10));
+    ASSERT_EQUAL_STRING("ababababab", out);
+
+    return 0;
+}
+
+/* Lengths of 15 or more use extension bytes, and literal
+ * runs longer than the input buffer are refilled as needed. */
+int test_lz_extended_lengths()
+{
+    char data[512];
+    size_t n = 0;
+
+    /* 300 literals, then a match of 40 from 300 back. */
+    data[n++] = (char)0xff;
+    data[n++] = (char)0xff;
+    data[n++] = (char)(300 - 15 - 255);
+    for (int i = 0; i < 300; i++) data[n++] = (char)(i & 0x7f);
+    data[n++] = (char)(300 & 0xff);
+    data[n++] = (char)(300 >> 8);
+    data[n++] = (char)(40 - 4 - 15);
+
+    lz_test_open(data, n);
+
+    char out[340];
+    ASSERT_EQUAL_INT(0, lz_decode(out, 340));
+
+    for (int i = 0; i < 300; i++) ASSERT(out[i] == (char)(i & 0x7f));
+    for (int i = 0; i < 40; i++) ASSERT(out[300 + i] == (char)(i & 0x7f));
+
+    return 0;
+}
+
+/* Code and data segments are decoded one after the other
+ * from the same stream. */
+int test_lz_two_segments()
+{
+    const char stream[] = {
+        0x30, 'a', 'b', 'c',
+        0x10, 'x', 0x01, 0x00
+    };
+    lz_test_open(stream, sizeof(stream));
+
+    char code[3];
+    char data[5];
+
+    ASSERT_EQUAL_INT(0, lz_decode(code, 3));
+    ASSERT_EQUAL_INT(0, lz_decode(data, 5));
+
+    ASSERT(memcmp(code, "abc", 3) == 0);
+    ASSERT(memcmp(data, "xxxxx", 5) == 0);
+
+    return 0;
+}
+
+/* A match from before the start of the segment is rejected. */
+int test_lz_bad_offset()
+{
+    const char stream[] = { 0x10, 'a', 0x02, 0x00 };
+    lz_test_open(stream, sizeof(stream));
+
+    char out[8];
+    ASSERT_EQUAL_INT(E_LZCORRUPT, lz_decode(out, 5));
+
+    return 0;
+}
+
+/* A stream that would write past the end of the segment is rejected. */
+int test_lz_overrun()
+{
+    const char stream[] = { 0x14, 'a', 0x01, 0x00 };
+    lz_test_open(stream, sizeof(stream));
+
+    char out[8];
+    ASSERT_EQUAL_INT(E_LZCORRUPT, lz_decode(out, 4));
+
+    return 0;
+}
+
+/* A stream that ends early is rejected. */
+int test_lz_truncated()
+{
+    const char stream[] = { 0x50, 'H', 'e' };
+    lz_test_open(stream, sizeof(stream));
+
+    char out[8];
+    ASSERT_EQUAL_INT(E_LZCORRUPT, lz_decode(out, 5));
+
+    return 0;
+}
+
+/* A stream which starts part way into a sector and runs over
+ * several is read across the sector boundaries. */
+int test_lz_sectors()
+{
+    static char data[1536];
+    size_t start = 100;
+    size_t n = start;
+
+    /* 1000 literals. */
+    data[n++] = (char)0xf0;
+    data[n++] = (char)0xff;
+    data[n++] = (char)0xff;
+    data[n++] = (char)0xff;
+    data[n++] = (char)(1000 - 15 - 3 * 255);
+    for (int i = 0; i < 1000; i++) data[n++] = (char)(i % 251);
+
+    mock_drive_init();
+    for (int i = 0; i < 3; i++) disk_write(&data[i * 512], disk_info.data_region + i);
+    current_cache_sector = 0xffffffff;
+
+    FileDescriptor_T * file = &fdtable[0];
+    file->mode = FMODE_READ;
+    file->current_cluster = 2;
+    file->sector = 0;
+    file->fpos_within_sector = start;
+    file->fpos = start;
+    file->size = n;
+
+    lz_begin(0);
+
+    static char out[1000];
+    ASSERT_EQUAL_INT(0, lz_decode(out, 1000));
+
+    for (int i = 0; i < 1000; i++) ASSERT(out[i] == (char)(i % 251));
+    ASSERT_EQUAL_INT(n, file->fpos);
+
+    return 0;
+}
@@ -113,3 +113,205 @@ int test_init_too_many()
 
     return 0;
 }
+
+/* Tests that a cached image can be found again by its key,
+ * and not by a different size.
+ */
+int test_cache_find()
+{
+    memory_init(16);
+
+    int p = memory_cache_allocate(5, 1000);
+    ASSERT_EQUAL_INT(0, p);
+
+    ASSERT_EQUAL_INT(0, memory_cache_find(5, 1000));
+    ASSERT_EQUAL_INT(E_NOPAGES, memory_cache_find(5, 1001));
+    ASSERT_EQUAL_INT(E_NOPAGES, memory_cache_find(6, 1000));
+
+    /* The cached page is not handed out while others are free. */
+    ASSERT_EQUAL_INT(1, memory_allocate());
+
+    return 0;
+}
+
+/* Tests that a cached page is reclaimed when there are
+ * no free pages left.
+ */
+int test_cache_reclaimed_by_allocate()
+{
+    memory_init(4);
+
+    ASSERT_EQUAL_INT(0, memory_cache_allocate(5, 1000));
+
+    for (int i = 1; i < 4; i++)
+    {
+        ASSERT_EQUAL_INT(i, memory_allocate());
+    }
+
+    /* Only the cached page is left. */
+    ASSERT_EQUAL_INT(0, memory_allocate());
+    ASSERT_EQUAL_INT(E_NOPAGES, memory_cache_find(5, 1000));
+
+    ASSERT_EQUAL_INT(E_NOPAGES, memory_allocate());
+
+    return 0;
+}
+
+/* Tests that the least recently used image is replaced
+ * when there is no free page for a new one.
+ */
+int test_cache_lru()
+{
+    memory_init(3);
+
+    ASSERT_EQUAL_INT(0, memory_cache_allocate(5, 1000));
+    ASSERT_EQUAL_INT(1, memory_cache_allocate(6, 2000));
+    ASSERT_EQUAL_INT(2, memory_allocate());
+
+    /* Use the first image, so the second is least recently used. */
+    ASSERT_EQUAL_INT(0, memory_cache_find(5, 1000));
+
+    ASSERT_EQUAL_INT(1, memory_cache_allocate(7, 3000));
+    ASSERT_EQUAL_INT(E_NOPAGES, memory_cache_find(6, 2000));
+    ASSERT_EQUAL_INT(0, memory_cache_find(5, 1000));
+    ASSERT_EQUAL_INT(1, memory_cache_find(7, 3000));
+
+    return 0;
+}
+
+/* Tests that invalidating an image frees its page.
+ */
+int test_cache_invalidate()
+{
+    memory_init(16);
+
+    ASSERT_EQUAL_INT(0, memory_cache_allocate(5, 1000));
+
+    memory_cache_invalidate(5);
+    ASSERT_EQUAL_INT(E_NOPAGES, memory_cache_find(5, 1000));
+
+    ASSERT_EQUAL_INT(0, memory_allocate());
+
+    return 0;
+}
+
+/* Tests that a shared page is only freed when its
+ * last reference is dropped.
+ */
+int test_shared_refs()
+{
+    memory_init(16);
+
+    int id = memory_shared_allocate(1);
+    ASSERT(id >= 0);
+
+    int page = memory_shared_page(id);
+    ASSERT_EQUAL_INT(0, page);
+
+    ASSERT_EQUAL_INT(0, memory_shared_grant(id, 2, 1));
+    ASSERT_EQUAL_INT(page, memory_shared_map(id, 2));
+
+    /* One reference left. */
+    memory_free(page);
+    ASSERT_EQUAL_INT(1, memory_allocate());
+
+    memory_free(page);
+    ASSERT_EQUAL_INT(E_NOSHARED, memory_shared_page(id));
+    ASSERT_EQUAL_INT(0, memory_allocate());
+
+    return 0;
+}
+
+/* Tests that a shared page can only be mapped or granted
+ * by processes that have been granted access.
+ */
+int test_shared_grant()
+{
+    memory_init(16);
+
+    int id = memory_shared_allocate(1);
+
+    ASSERT_EQUAL_INT(E_NOTGRANTED, memory_shared_map(id, 2));
+    ASSERT_EQUAL_INT(E_NOTGRANTED, memory_shared_grant(id, 3, 2));
+
+    ASSERT_EQUAL_INT(0, memory_shared_grant(id, 2, 1));
+    ASSERT_EQUAL_INT(0, memory_shared_grant(id, 3, 2));
+    ASSERT(memory_shared_map(id, 3) >= 0);
+
+    ASSERT_EQUAL_INT(E_NOSHARED, memory_shared_map(id + 1, 1));
+    ASSERT_EQUAL_INT(E_NOSHARED, memory_shared_grant(-1, 2, 1));
+
+    return 0;
+}
+
+/* Tests that access granted to a process is withdrawn once
+ * it has exited, without affecting other processes.
+ */
+int test_shared_revoke()
+{
+    memory_init(16);
+
+    int id = memory_shared_allocate(1);
+    ASSERT_EQUAL_INT(0, memory_shared_grant(id, 2, 1));
+
+    memory_shared_revoke(2);
+    ASSERT_EQUAL_INT(E_NOTGRANTED, memory_shared_map(id, 2));
+    ASSERT_EQUAL_INT(E_NOTGRANTED, memory_shared_grant(id, 3, 2));
+
+    ASSERT(memory_shared_map(id, 1) >= 0);
+
+    return 0;
+}
+
+/* Checks that pages record the process they were allocated to,
+ * and that freeing them gives them back.
+ */
+int test_alloc_owner()
+{
+    memory_init(16);
+
+    ASSERT_EQUAL_INT(0, memory_allocate_for(3));
+    ASSERT_EQUAL_INT(1, memory_allocate_for(5));
+    ASSERT_EQUAL_INT(2, memory_allocate_for(3));
+    ASSERT_EQUAL_INT(3, memory_allocate());
+
+    ASSERT_EQUAL_INT(3, memory_owner(0));
+    ASSERT_EQUAL_INT(MEMORY_KERNEL, memory_owner(3));
+    ASSERT_EQUAL_INT(2, memory_owned(3));
+
+    memory_free(0);
+    ASSERT_EQUAL_INT(1, memory_owned(3));
+    ASSERT_EQUAL_INT(MEMORY_KERNEL, memory_owner(0));
+
+    /* The lowest free page is found first. */
+    ASSERT_EQUAL_INT(0, memory_allocate_for(7));
+
+    return 0;
+}
+
+/* Checks the pages used, high-water mark and failure counters.
+ */
+int test_alloc_stats()
+{
+    memory_init(12);
+
+    for (int i = 0; i < 12; i++) memory_allocate();
+    ASSERT_EQUAL_INT(E_NOPAGES, memory_allocate());
+    ASSERT_EQUAL_INT(E_NOPAGES, memory_allocate());
+
+    for (int i = 0; i < 12; i += 2) memory_free(i);
+
+    ASSERT_EQUAL_INT(6, memory_stats.used);
+    ASSERT_EQUAL_INT(12, memory_stats.peak);
+    ASSERT_EQUAL_INT(2, memory_stats.failures);
+
+    /* Freeing a free page changes nothing. */
+    memory_free(0);
+    ASSERT_EQUAL_INT(6, memory_stats.used);
+
+    /* Cached images are not counted. */
+    ASSERT(memory_cache_allocate(0x10, 100) >= 0);
+    ASSERT_EQUAL_INT(6, memory_stats.used);
+
+    return 0;
+}
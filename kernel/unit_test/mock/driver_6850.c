@@ -0,0 +1,15 @@
+#include <stddef.h>
+#include <stdint.h>
+
+/* Last value written to the #6850 control register. */
+uint8_t mock_6850_control;
+
+void driver_6850_tx(const char * s, size_t count)
+{
+
+}
+
+void driver_6850_control(uint8_t control)
+{
+    mock_6850_control = control;
+}
@@ -0,0 +1,14 @@
+#include <stdbool.h>
+
+/* Set while interrupts are enabled. */
+bool mock_interrupts_enabled;
+
+void interrupt_enable(void)
+{
+    mock_interrupts_enabled = true;
+}
+
+void interrupt_disable(void)
+{
+    mock_interrupts_enabled = false;
+}
@@ -1,6 +1,28 @@
 #ifndef _MOCK_H
 #define _MOCK_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
 void mock_drive_init(void);
 
+/* Banked RAM, as written by ram_copy.
+ * Indexed from 0x8000. */
+extern uint8_t mock_banked_ram[0x8000];
+extern uint8_t mock_ram_copy_bank;
+extern int mock_ram_copy_calls;
+extern size_t mock_ram_copy_bytes;
+
+void mock_ram_copy_reset(void);
+
+/* Last value written to the #6850 control register. */
+extern uint8_t mock_6850_control;
+
+/* Set while interrupts are enabled. */
+extern bool mock_interrupts_enabled;
+
+#define MOCK_6850_TX_INT 0x20
+#define MOCK_6850_RTS_HIGH 0x40
+
 #endif
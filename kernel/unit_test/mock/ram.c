@@ -1,11 +1,48 @@
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 
 uint8_t ram_bank;
 
+/* Contents of the most recently copied-to bank. */
+uint8_t mock_banked_ram[0x8000];
+uint8_t mock_ram_copy_bank;
+int mock_ram_copy_calls;
+size_t mock_ram_copy_bytes;
+
 void ram_copy(char * dst, uint8_t bank, char * src, size_t n)
 {
+    uintptr_t offset = (uintptr_t)dst - 0x8000;
+    memcpy(&mock_banked_ram[offset], src, n);
+
+    mock_ram_copy_bank = bank;
+    mock_ram_copy_calls++;
+    mock_ram_copy_bytes += n;
+}
+
+#define MOCK_BANKED(_p) ((uintptr_t)(_p) >= 0x8000 && (uintptr_t)(_p) < 0x10000)
+
+/* All banks share mock_banked_ram. Addresses in 0x8000-0xffff
+ * are banked, anything else is a host buffer. */
+void ram_copy_banks(char * dst, uint8_t dst_bank, char * src, uint8_t src_bank, size_t n)
+{
+    (void)src_bank;
+
+    char * d = MOCK_BANKED(dst) ? (char *)&mock_banked_ram[(uintptr_t)dst - 0x8000] : dst;
+    char * s = MOCK_BANKED(src) ? (char *)&mock_banked_ram[(uintptr_t)src - 0x8000] : src;
+    memmove(d, s, n);
 
+    mock_ram_copy_bank = dst_bank;
+    mock_ram_copy_calls++;
+    mock_ram_copy_bytes += n;
+}
+
+void mock_ram_copy_reset(void)
+{
+    memset(mock_banked_ram, 0, sizeof(mock_banked_ram));
+    mock_ram_copy_bank = 0;
+    mock_ram_copy_calls = 0;
+    mock_ram_copy_bytes = 0;
 }
 
 void ram_bank_set(uint8_t bank)
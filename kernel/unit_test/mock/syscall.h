@@ -8,6 +8,7 @@
 #include <stddef.h>
 
 #define SMODE_BINARY 0x01
+#define SMODE_BLOCKING 0x02
 
 #define FMODE_READ 0x01
 #define FMODE_WRITE 0x02
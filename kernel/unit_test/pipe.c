@@ -0,0 +1,173 @@
+#include <string.h>
+
+#include <include/pipe.h>
+#include <include/scheduler.h>
+
+#include <test.h>
+
+void timer_tick(void);
+
+/* Creates a pipe with one reader and one writer, with
+ * process 1 running and process 2 ready.
+ */
+static int pipe_setup(void)
+{
+    pipe_init();
+    scheduler_init();
+    scheduler_add(1);
+    scheduler_add(2);
+    timer_tick();
+
+    int p = pipe_create();
+    pipe_attach(p, true);
+    pipe_attach(p, false);
+
+    return p;
+}
+
+/* Checks that bytes come out of a pipe in the order they went in.
+ */
+int test_pipe_write_read()
+{
+    int p = pipe_setup();
+    ASSERT_EQUAL_INT(0, p);
+
+    ASSERT_EQUAL_INT(3, pipe_write(p, "abc", 3));
+    ASSERT_EQUAL_INT('a', pipe_read(p));
+    ASSERT_EQUAL_INT('b', pipe_read(p));
+    ASSERT_EQUAL_INT('c', pipe_read(p));
+
+    return 0;
+}
+
+/* Checks that writes wrap around the end of the buffer.
+ */
+int test_pipe_wrap()
+{
+    int p = pipe_setup();
+
+    char buf[PIPE_SIZE];
+    memset(buf, 'x', sizeof(buf));
+    ASSERT_EQUAL_INT(PIPE_SIZE - 2, pipe_write(p, buf, PIPE_SIZE - 2));
+    for (int i = 0; i < PIPE_SIZE - 2; i++) pipe_read(p);
+
+    ASSERT_EQUAL_INT(4, pipe_write(p, "wxyz", 4));
+    ASSERT_EQUAL_INT('w', pipe_read(p));
+    ASSERT_EQUAL_INT('x', pipe_read(p));
+    ASSERT_EQUAL_INT('y', pipe_read(p));
+    ASSERT_EQUAL_INT('z', pipe_read(p));
+
+    return 0;
+}
+
+/* Checks that a write to a full pipe is cut short and blocks the
+ * writer, and that reading from it wakes the writer again.
+ */
+int test_pipe_full_blocks()
+{
+    int p = pipe_setup();
+
+    char buf[PIPE_SIZE + 10];
+    memset(buf, 'x', sizeof(buf));
+    ASSERT_EQUAL_INT(PIPE_SIZE, pipe_write(p, buf, sizeof(buf)));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(1));
+
+    ASSERT_EQUAL_INT(0, pipe_write(p, buf, 10));
+
+    timer_tick();
+    ASSERT_EQUAL_INT(2, scheduler_current_pid());
+    ASSERT_EQUAL_INT('x', pipe_read(p));
+    ASSERT(scheduler_state(1) != TASK_BLOCKED);
+
+    return 0;
+}
+
+/* Checks that reading from an empty pipe blocks the reader, and that
+ * writing to it wakes the reader again.
+ */
+int test_pipe_empty_blocks()
+{
+    int p = pipe_setup();
+
+    ASSERT_EQUAL_INT(PIPE_BLOCKED, pipe_read(p));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(1));
+
+    timer_tick();
+    ASSERT_EQUAL_INT(2, scheduler_current_pid());
+    ASSERT_EQUAL_INT(1, pipe_write(p, "a", 1));
+    ASSERT(scheduler_state(1) != TASK_BLOCKED);
+
+    return 0;
+}
+
+/* Checks that the reader sees end-of-file once the pipe is empty and
+ * the writer has gone, and that the pipe is freed when the reader goes.
+ */
+int test_pipe_eof()
+{
+    int p = pipe_setup();
+
+    pipe_write(p, "a", 1);
+    pipe_detach(p, true);
+
+    ASSERT_EQUAL_INT('a', pipe_read(p));
+    ASSERT_EQUAL_INT(PIPE_EOF, pipe_read(p));
+    ASSERT(pipe_valid(p));
+
+    pipe_detach(p, false);
+    ASSERT(!pipe_valid(p));
+
+    return 0;
+}
+
+/* Checks that writes to a pipe without readers are discarded.
+ */
+int test_pipe_no_readers()
+{
+    int p = pipe_setup();
+    pipe_detach(p, false);
+
+    char buf[PIPE_SIZE * 2];
+    memset(buf, 'x', sizeof(buf));
+    ASSERT_EQUAL_INT(sizeof(buf), pipe_write(p, buf, sizeof(buf)));
+    ASSERT(scheduler_state(1) != TASK_BLOCKED);
+
+    return 0;
+}
+
+/* Checks that pipes run out.
+ */
+int test_pipe_too_many()
+{
+    pipe_init();
+
+    for (int i = 0; i < PIPES_MAX; i++)
+    {
+        ASSERT_EQUAL_INT(i, pipe_create());
+    }
+
+    ASSERT_EQUAL_INT(E_NOPIPES, pipe_create());
+
+    return 0;
+}
+
+/* Checks that pipe_readn reads everything waiting, and
+ * reports end-of-file once the writer has gone.
+ */
+int test_pipe_readn()
+{
+    int p = pipe_setup();
+
+    char buf[8];
+    pipe_write(p, "abc", 3);
+    ASSERT_EQUAL_INT(3, pipe_readn(p, buf, sizeof(buf)));
+    ASSERT(memcmp(buf, "abc", 3) == 0);
+
+    ASSERT_EQUAL_INT(PIPE_BLOCKED, pipe_readn(p, buf, sizeof(buf)));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(1));
+
+    pipe_detach(p, true);
+    ASSERT_EQUAL_INT(PIPE_EOF, pipe_readn(p, buf, sizeof(buf)));
+
+    return 0;
+}
@@ -0,0 +1,291 @@
+#include <string.h>
+
+#include <include/process.h>
+#include <include/scheduler.h>
+#include <include/memory.h>
+
+#include <test.h>
+
+#define BANKED(_addr) (&mock_banked_ram[(_addr) - 0x8000])
+#define BANKED_UINT16(_addr) (*(uint16_t *)BANKED(_addr))
+
+/* Tests that arguments are packed into a single block
+ * at the start of the per-process area.
+ */
+int test_process_spawn_args()
+{
+    scheduler_init();
+    mock_ram_copy_reset();
+
+    char * argv[2] = { "hello", "world!" };
+
+    int e = process_spawn(3, argv, 2);
+    ASSERT_EQUAL_INT(0, e);
+
+    /* One copy, of exactly the bytes used. */
+    ASSERT_EQUAL_INT(1, mock_ram_copy_calls);
+    ASSERT_EQUAL_INT(0x10 + 4 + 6 + 7, (int)mock_ram_copy_bytes);
+
+    ASSERT_EQUAL_INT(2, BANKED_UINT16(0xf800));
+
+    uint16_t arg0 = BANKED_UINT16(0xf810);
+    uint16_t arg1 = BANKED_UINT16(0xf812);
+    ASSERT_EQUAL_INT(0xf814, arg0);
+    ASSERT_EQUAL_INT(0xf81a, arg1);
+
+    ASSERT_EQUAL_STRING("hello", (char *)BANKED(arg0));
+    ASSERT_EQUAL_STRING("world!", (char *)BANKED(arg1));
+
+    ASSERT_EQUAL_INT(TASK_READY, scheduler_state(3));
+
+    return 0;
+}
+
+/* Tests that a process with no arguments only has
+ * argc copied into its area.
+ */
+int test_process_spawn_no_args()
+{
+    scheduler_init();
+    mock_ram_copy_reset();
+
+    int e = process_spawn(3, NULL, 0);
+    ASSERT_EQUAL_INT(0, e);
+
+    ASSERT_EQUAL_INT(1, mock_ram_copy_calls);
+    ASSERT_EQUAL_INT(0x10, (int)mock_ram_copy_bytes);
+    ASSERT_EQUAL_INT(0, BANKED_UINT16(0xf800));
+
+    return 0;
+}
+
+/* Tests that too many arguments results in an error,
+ * and the process is not scheduled.
+ */
+int test_process_spawn_too_many_args()
+{
+    scheduler_init();
+    mock_ram_copy_reset();
+
+    char * argv[17];
+    for (int i = 0; i < 17; i++) argv[i] = "a";
+
+    int e = process_spawn(3, argv, 17);
+    ASSERT_EQUAL_INT(E_TOOMANYARGS, e);
+    ASSERT_EQUAL_INT(0, mock_ram_copy_calls);
+    ASSERT_EQUAL_INT(TASK_FREE, scheduler_state(3));
+
+    return 0;
+}
+
+/* Tests that arguments too long for the per-process
+ * area result in an error, and the process is not scheduled.
+ */
+int test_process_spawn_args_too_long()
+{
+    scheduler_init();
+    mock_ram_copy_reset();
+
+    char arg[200];
+    memset(arg, 'a', 199);
+    arg[199] = '\0';
+
+    char * argv[3] = { arg, arg, arg };
+
+    int e = process_spawn(3, argv, 3);
+    ASSERT_EQUAL_INT(E_ARGSTOOLONG, e);
+    ASSERT_EQUAL_INT(0, mock_ram_copy_calls);
+    ASSERT_EQUAL_INT(TASK_FREE, scheduler_state(3));
+
+    return 0;
+}
+
+/* Tests that auxiliary banks are allocated up to the limit,
+ * and can be reused once freed.
+ */
+int test_process_bank_alloc()
+{
+    memory_init(16);
+    process_init();
+    process_set_current(1);
+
+    for (int i = 0; i < PROCESS_BANKS_MAX; i++)
+    {
+        ASSERT_EQUAL_INT(i, process_bank_alloc());
+    }
+
+    ASSERT_EQUAL_INT(E_NOBANKS, process_bank_alloc());
+
+    ASSERT_EQUAL_INT(0, process_bank_free(2));
+    ASSERT_EQUAL_INT(E_NOBANK, process_bank_free(2));
+    ASSERT_EQUAL_INT(2, process_bank_alloc());
+
+    return 0;
+}
+
+/* Tests that data written to an auxiliary bank is read back
+ * from the bank it was written to.
+ */
+int test_process_bank_read_write()
+{
+    memory_init(16);
+    process_init();
+    process_set_current(1);
+    mock_ram_copy_reset();
+
+    int h = process_bank_alloc();
+    ASSERT_EQUAL_INT(0, h);
+
+    ASSERT_EQUAL_INT(6, process_bank_write(h, 0x1000, "hello", 6));
+    ASSERT_EQUAL_INT(process_info(1)->banks[h], mock_ram_copy_bank);
+    ASSERT_EQUAL_STRING("hello", (char *)BANKED(0x9000));
+
+    char buf[6];
+    ASSERT_EQUAL_INT(6, process_bank_read(h, 0x1000, buf, 6));
+    ASSERT_EQUAL_STRING("hello", buf);
+
+    return 0;
+}
+
+/* Tests that copies outside an auxiliary bank,
+ * or to a bank that is not owned, are rejected.
+ */
+int test_process_bank_range()
+{
+    memory_init(16);
+    process_init();
+    process_set_current(1);
+    mock_ram_copy_reset();
+
+    char buf[16];
+
+    ASSERT_EQUAL_INT(E_NOBANK, process_bank_read(0, 0, buf, 16));
+    ASSERT_EQUAL_INT(E_NOBANK, process_bank_read(-1, 0, buf, 16));
+    ASSERT_EQUAL_INT(E_NOBANK, process_bank_read(PROCESS_BANKS_MAX, 0, buf, 16));
+
+    int h = process_bank_alloc();
+
+    ASSERT_EQUAL_INT(16, process_bank_read(h, 0x8000 - 16, buf, 16));
+    ASSERT_EQUAL_INT(E_BANKRANGE, process_bank_read(h, 0x8000 - 15, buf, 16));
+    ASSERT_EQUAL_INT(E_BANKRANGE, process_bank_write(h, 0xfff0, buf, 16));
+
+    ASSERT_EQUAL_INT(1, mock_ram_copy_calls);
+
+    return 0;
+}
+
+void timer_tick(void);
+
+/* Tests that data written to a shared bank by one process
+ * can be read by another it has been granted to.
+ */
+int test_process_shared_bank()
+{
+    memory_init(16);
+    process_init();
+    scheduler_init();
+    mock_ram_copy_reset();
+
+    /* Process 1 creates the bank and grants it to process 2. */
+    scheduler_add(1);
+    scheduler_add(2);
+    timer_tick();
+    process_set_current(scheduler_current_pid());
+    ASSERT_EQUAL_INT(1, scheduler_current_pid());
+
+    uint8_t id = 0xff;
+    int h1 = process_shared_alloc(&id);
+    ASSERT_EQUAL_INT(0, h1);
+    ASSERT(id != 0xff);
+
+    ASSERT_EQUAL_INT(5, process_bank_write(h1, 0x10, "pipe", 5));
+    ASSERT_EQUAL_INT(0, process_shared_grant(id, 2));
+
+    timer_tick();
+    process_set_current(scheduler_current_pid());
+    ASSERT_EQUAL_INT(2, scheduler_current_pid());
+
+    /* The first slot is used, so the handle differs from the creator's. */
+    ASSERT_EQUAL_INT(0, process_bank_alloc());
+    int h2 = process_shared_map(id);
+    ASSERT_EQUAL_INT(1, h2);
+    ASSERT_EQUAL_INT(process_info(1)->banks[h1], process_info(2)->banks[h2]);
+
+    char buf[5];
+    ASSERT_EQUAL_INT(5, process_bank_read(h2, 0x10, buf, 5));
+    ASSERT_EQUAL_STRING("pipe", buf);
+
+    return 0;
+}
+
+/* Tests that a clone gets its own bank and descriptor, and a stack
+ * frame which resumes it after the syscall with a return value of 0.
+ */
+int test_process_clone()
+{
+    memory_init(16);
+    process_init();
+    scheduler_init();
+    mock_ram_copy_reset();
+
+    /* Stand in for a loaded process. */
+    ProcessDescriptor_T * parent = (ProcessDescriptor_T *)process_info(0);
+    parent->base_address = 0x8000;
+    parent->bank = (uint8_t)memory_allocate_for(0);
+    parent->sighandlers.cancel = (void *)0x9000;
+
+    scheduler_add(0);
+    timer_tick();
+    process_set_current(0);
+
+    /* As entered from pclone. */
+    mock_interrupts_enabled = true;
+
+    int pd = process_clone(0xf700, 0x8123, 0xf6f0);
+    ASSERT_EQUAL_INT(1, pd);
+
+    /* The frame is written, and the task added, with them disabled. */
+    ASSERT(!mock_interrupts_enabled);
+    ASSERT_EQUAL_INT(TASK_READY, scheduler_state(1));
+
+    const ProcessDescriptor_T * child = process_info(1);
+    ASSERT(child->bank != parent->bank);
+    ASSERT_EQUAL_INT(1, memory_owner(child->bank));
+    ASSERT(child->sighandlers.cancel == (void *)0x9000);
+
+    /* Saved stack pointer, then IY, IX, BC, DE, HL, AF and PC. */
+    ASSERT_EQUAL_INT(0xf6f2, BANKED_UINT16(0xfffe));
+    ASSERT_EQUAL_INT(0xf6f0, BANKED_UINT16(0xf6f4));
+    ASSERT_EQUAL_INT(0, BANKED_UINT16(0xf6f8));
+    ASSERT_EQUAL_INT(0x8123, BANKED_UINT16(0xf6fe));
+
+    return 0;
+}
+
+/* Tests that a loaded process can be released before it is
+ * spawned, giving its bank back, but not afterwards.
+ */
+int test_process_free()
+{
+    memory_init(16);
+    process_init();
+    scheduler_init();
+
+    /* Stand in for loaded processes. */
+    for (int pd = 0; pd < 2; pd++)
+    {
+        ProcessDescriptor_T * p = process_descriptor(pd);
+        p->base_address = 0x8000;
+        p->bank = (uint8_t)memory_allocate_for(pd);
+    }
+
+    ASSERT_EQUAL_INT(0, process_free(0));
+    ASSERT_EQUAL_INT(0, process_info(0)->base_address);
+    ASSERT_EQUAL_INT(0, memory_owned(0));
+    ASSERT_EQUAL_INT(E_NOPROCESS, process_free(0));
+
+    scheduler_add(1);
+    ASSERT_EQUAL_INT(E_NOPROCESS, process_free(1));
+
+    return 0;
+}
@@ -1,4 +1,5 @@
 #include <include/scheduler.h>
+#include <include/process.h>
 
 #include <test.h>
 
@@ -265,3 +266,189 @@ int test_schedule_task_not_scheduled_when_waiting(void)
 
     return 0;
 }
+
+extern uint16_t scheduler_ticks;
+
+/* Simulates a timer interrupt. */
+void timer_tick(void)
+{
+    scheduler_ticks++;
+    scheduler_tick();
+}
+
+/* Tests that a sleeping task is blocked for the given
+ * number of ticks and is then scheduled again.
+ */
+int test_schedule_sleep()
+{
+    scheduler_init();
+
+    scheduler_add(5);
+    scheduler_add(6);
+
+    timer_tick();
+    ASSERT_EQUAL_INT(TASK_RUNNING, scheduler_state(5));
+
+    uint16_t wake = scheduler_sleep(3);
+    ASSERT_EQUAL_UINT(4, wake);
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(5));
+    ASSERT_EQUAL_INT(EVENT_TIMER, scheduler_event(5));
+
+    /* PID 6 should run for the next two ticks. */
+    for (int i = 0; i < 2; i++)
+    {
+        timer_tick();
+        ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(5));
+        ASSERT_EQUAL_INT(TASK_RUNNING, scheduler_state(6));
+    }
+
+    /* Third tick wakes PID 5. */
+    timer_tick();
+    ASSERT_EQUAL_INT(TASK_RUNNING, scheduler_state(5));
+    ASSERT_EQUAL_INT(EVENT_NO_EVENT, scheduler_event(5));
+    ASSERT_EQUAL_INT(TASK_READY, scheduler_state(6));
+
+    return 0;
+}
+
+/* Tests that sleeping tasks are woken in order of wake time,
+ * regardless of the order in which they went to sleep.
+ */
+int test_schedule_sleep_ordering()
+{
+    scheduler_init();
+
+    scheduler_add(1);
+    scheduler_add(2);
+    scheduler_add(3);
+    scheduler_add(4);
+
+    timer_tick();
+    scheduler_sleep(5);
+
+    timer_tick();
+    scheduler_sleep(2);
+
+    timer_tick();
+    scheduler_sleep(3);
+
+    /* PIDs 1, 2 and 3 wake on ticks 6, 4 and 6 respectively. */
+    ASSERT_EQUAL_UINT(3, scheduler_ticks);
+
+    timer_tick();
+    ASSERT(scheduler_state(2) != TASK_BLOCKED);
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(1));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(3));
+
+    timer_tick();
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(1));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(3));
+
+    timer_tick();
+    ASSERT(scheduler_state(1) != TASK_BLOCKED);
+    ASSERT(scheduler_state(3) != TASK_BLOCKED);
+
+    return 0;
+}
+
+/* Tests that ticks skipped by the scheduler (e.g. while
+ * in kernel space) still count towards a task's sleep.
+ */
+int test_schedule_sleep_missed_ticks()
+{
+    scheduler_init();
+
+    scheduler_add(5);
+    scheduler_add(6);
+
+    timer_tick();
+    scheduler_sleep(10);
+
+    /* Scheduler does not run for these ticks. */
+    scheduler_ticks += 9;
+
+    timer_tick();
+    ASSERT(scheduler_state(5) != TASK_BLOCKED);
+    ASSERT_EQUAL_INT(EVENT_NO_EVENT, scheduler_event(5));
+
+    return 0;
+}
+
+/* Tests that the scheduler does not hang if every
+ * task is sleeping, and wakes the task when due.
+ */
+int test_schedule_sleep_all_blocked()
+{
+    scheduler_init();
+
+    scheduler_add(7);
+
+    timer_tick();
+    scheduler_sleep(2);
+
+    timer_tick();
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(7));
+    ASSERT_EQUAL_INT(7, scheduler_current_pid());
+
+    timer_tick();
+    ASSERT_EQUAL_INT(TASK_RUNNING, scheduler_state(7));
+
+    return 0;
+}
+
+/* Tests that a task which exits while in the sleep
+ * queue is not woken, and does not delay other sleepers.
+ */
+int test_schedule_sleep_exit()
+{
+    scheduler_init();
+
+    scheduler_add(1);
+    scheduler_add(2);
+    scheduler_add(3);
+
+    timer_tick();
+    scheduler_sleep(2);
+
+    timer_tick();
+    scheduler_sleep(3);
+
+    /* PID 1 exits before its slice ends. */
+    scheduler_exit(1, 0);
+
+    timer_tick();
+    timer_tick();
+    ASSERT_EQUAL_INT(TASK_FINISHED, scheduler_state(1));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(2));
+
+    timer_tick();
+    ASSERT_EQUAL_INT(TASK_FINISHED, scheduler_state(1));
+    ASSERT_EQUAL_INT(TASK_RUNNING, scheduler_state(2));
+
+    return 0;
+}
+
+/* Tests that each tick is charged to the task
+ * which was running when it occurred.
+ */
+int test_schedule_tick_accounting()
+{
+    scheduler_init();
+
+    scheduler_add(3);
+    scheduler_add(4);
+
+    uint16_t ticks3 = process_info(3)->stats.ticks;
+    uint16_t ticks4 = process_info(4)->stats.ticks;
+
+    /* First tick only starts PID 3. */
+    timer_tick();
+
+    for (int i = 0; i < 10; i++) timer_tick();
+
+    /* Ten ticks are shared equally between the two tasks. */
+    ASSERT_EQUAL_UINT(ticks3 + 5, process_info(3)->stats.ticks);
+    ASSERT_EQUAL_UINT(ticks4 + 5, process_info(4)->stats.ticks);
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <include/sysstat.h>
+
+#include <test.h>
+
+static uint16_t fake_time;
+
+static uint16_t fake_clock(void)
+{
+    return fake_time;
+}
+
+/* Tests that each syscall is counted against its own entry,
+ * indexed by table offset / 2.
+ */
+int test_sysstat_count()
+{
+    sysstat_init();
+
+    sysstat_enter(4);
+    sysstat_exit();
+    sysstat_enter(4);
+    sysstat_exit();
+    sysstat_enter(0);
+    sysstat_exit();
+
+    SysStat_T buf[3];
+    ASSERT_EQUAL_INT(3, (int)sysstat_read(buf, 3));
+    ASSERT_EQUAL_INT(1, buf[0].count);
+    ASSERT_EQUAL_INT(0, buf[1].count);
+    ASSERT_EQUAL_INT(2, buf[2].count);
+
+    return 0;
+}
+
+/* Tests that the time between entry and return is added up,
+ * and that a syscall which never returned is not charged.
+ */
+int test_sysstat_time()
+{
+    sysstat_init();
+    sysstat_clock = fake_clock;
+
+    fake_time = 10;
+    sysstat_enter(2);
+    fake_time = 13;
+    sysstat_exit();
+
+    sysstat_enter(2);
+    fake_time = 20;
+    sysstat_exit();
+
+    /* Blocked, so re-issued without returning. */
+    sysstat_enter(4);
+    sysstat_enter(4);
+    fake_time = 21;
+    sysstat_exit();
+
+    SysStat_T buf[SYSSTAT_MAX];
+    ASSERT_EQUAL_INT(SYSSTAT_MAX, (int)sysstat_read(buf, 100));
+    ASSERT_EQUAL_INT(10, buf[1].time);
+    ASSERT_EQUAL_INT(2, buf[2].count);
+    ASSERT_EQUAL_INT(1, buf[2].time);
+
+    return 0;
+}
@@ -0,0 +1,509 @@
+#include <string.h>
+
+#include <include/terminal.h>
+#include <include/process.h>
+#include <include/scheduler.h>
+#include <include/pipe.h>
+
+#include <test.h>
+
+void timer_tick(void);
+
+#define TX_ENABLED() ((mock_6850_control & (MOCK_6850_TX_INT | MOCK_6850_RTS_HIGH)) == MOCK_6850_TX_INT)
+#define RTS_HIGH() ((mock_6850_control & (MOCK_6850_TX_INT | MOCK_6850_RTS_HIGH)) == MOCK_6850_RTS_HIGH)
+
+/* Stands in for a loaded process. */
+static void terminal_add_process(int pid)
+{
+    process_descriptor(pid)->base_address = 0x8000;
+    process_descriptor(pid)->termstatus = 0;
+    scheduler_add(pid);
+}
+
+/* Starts process 0 running with the active terminal,
+ * with nothing queued for the terminal. */
+static void terminal_setup(void)
+{
+    process_init();
+    scheduler_init();
+    terminal_init();
+    mock_6850_control = 0;
+
+    terminal_add_process(0);
+    terminal_set_active(0);
+    timer_tick();
+}
+
+/* Checks that written bytes are sent from the transmit interrupt
+ * in order, and that the interrupt is disabled once they have gone.
+ */
+int test_terminal_tx_order()
+{
+    terminal_setup();
+
+    ASSERT_EQUAL_INT(3, terminal_write("abc", 3));
+    ASSERT(TX_ENABLED());
+
+    ASSERT_EQUAL_INT('a', terminal_tx_next());
+    ASSERT_EQUAL_INT('b', terminal_tx_next());
+    ASSERT_EQUAL_INT('c', terminal_tx_next());
+    ASSERT(TX_ENABLED());
+
+    ASSERT_EQUAL_INT(-1, terminal_tx_next());
+    ASSERT(!TX_ENABLED());
+
+    return 0;
+}
+
+/* Checks that a write which does not fit in the transmit buffer
+ * is cut short and blocks the writer until the buffer has drained.
+ */
+int test_terminal_tx_full()
+{
+    terminal_setup();
+
+    char buf[300];
+    memset(buf, 'x', sizeof(buf));
+
+    ASSERT_EQUAL_INT(255, terminal_write(buf, sizeof(buf)));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(0));
+
+    /* Still blocked with the buffer more than half full. */
+    for (int i = 0; i < 127; i++) terminal_tx_next();
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(0));
+
+    terminal_tx_next();
+    ASSERT_EQUAL_INT(TASK_READY, scheduler_state(0));
+
+    return 0;
+}
+
+/* Checks that bytes written before any process is scheduled
+ * are sent straight away rather than queued.
+ */
+int test_terminal_tx_unscheduled()
+{
+    process_init();
+    scheduler_init();
+    terminal_init();
+    mock_6850_control = 0;
+
+    ASSERT_EQUAL_INT(3, terminal_write("abc", 3));
+    ASSERT(!TX_ENABLED());
+    ASSERT_EQUAL_INT(-1, terminal_tx_next());
+
+    return 0;
+}
+
+/* Checks that in blocking mode a read with no input blocks the
+ * reader, and that the next byte received wakes it.
+ */
+int test_terminal_read_blocking()
+{
+    terminal_setup();
+
+    ASSERT_EQUAL_INT(-1, terminal_get());
+    ASSERT_EQUAL_INT(TASK_RUNNING, scheduler_state(0));
+
+    terminal_set_mode(TERMINAL_MODE_BLOCKING);
+    ASSERT_EQUAL_INT(TERMINAL_BLOCKED, terminal_get());
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(0));
+
+    terminal_put('a');
+    ASSERT_EQUAL_INT(TASK_READY, scheduler_state(0));
+    ASSERT_EQUAL_INT('a', terminal_get());
+
+    return 0;
+}
+
+/* Checks that input goes to the process with the active terminal,
+ * and stays with it when the active terminal changes.
+ */
+int test_terminal_read_active()
+{
+    terminal_setup();
+    terminal_add_process(1);
+
+    terminal_put('a');
+    ASSERT_EQUAL_INT(0, terminal_set_active(1));
+    terminal_put('b');
+
+    ASSERT(!(process_info(0)->termstatus & TERMSTATUS_ACTIVE));
+    ASSERT(process_info(1)->termstatus & TERMSTATUS_ACTIVE);
+
+    /* Process 0 is running. */
+    ASSERT_EQUAL_INT('a', terminal_get());
+    ASSERT_EQUAL_INT(-1, terminal_get());
+
+    timer_tick();
+    ASSERT_EQUAL_INT(1, scheduler_current_pid());
+    ASSERT_EQUAL_INT('b', terminal_get());
+
+    return 0;
+}
+
+/* Checks that the active terminal goes back to the
+ * process which handed it over, once the new owner exits.
+ */
+int test_terminal_active_exit()
+{
+    terminal_setup();
+    terminal_add_process(1);
+    terminal_add_process(2);
+
+    ASSERT_EQUAL_INT(0, terminal_set_active(1));
+    ASSERT_EQUAL_INT(1, terminal_set_active(2));
+
+    terminal_exit(2);
+    ASSERT_EQUAL_INT(1, terminal_active_pid());
+
+    /* Process 0 has exited, so there is nobody to go back to. */
+    scheduler_exit(0, 0);
+    terminal_exit(1);
+    ASSERT_EQUAL_INT(TERMINAL_NONE, terminal_active_pid());
+
+    ASSERT_EQUAL_INT(E_NOTERMINAL, terminal_set_active(3));
+
+    return 0;
+}
+
+/* Feeds a string to the receive interrupt. */
+static void terminal_type(const char * s)
+{
+    while (*s) terminal_put(*s++);
+}
+
+/* Checks that readline waits for a whole line, which is
+ * edited and echoed as it is typed.
+ */
+int test_terminal_readline()
+{
+    terminal_setup();
+
+    char line[16];
+    ASSERT_EQUAL_INT(TERMINAL_BLOCKED, terminal_readline(line, sizeof(line)));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(0));
+
+    terminal_type("lisx\bt");
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(0));
+
+    terminal_type("\r");
+    ASSERT_EQUAL_INT(TASK_READY, scheduler_state(0));
+
+    ASSERT_EQUAL_INT(4, terminal_readline(line, sizeof(line)));
+    ASSERT_EQUAL_STRING("list", line);
+
+    /* Echo. */
+    char echo[16];
+    int n = 0;
+    int c;
+    while ((c = terminal_tx_next()) >= 0) echo[n++] = (char)c;
+    echo[n] = '\0';
+    ASSERT_EQUAL_STRING("lisx\b \bt\r\n", echo);
+
+    return 0;
+}
+
+/* Checks that bytes typed before readline is called are
+ * part of the line, and that long lines are truncated.
+ */
+int test_terminal_readline_typeahead()
+{
+    terminal_setup();
+
+    terminal_type("hello world\r");
+
+    char line[6];
+    ASSERT_EQUAL_INT(5, terminal_readline(line, sizeof(line)));
+    ASSERT_EQUAL_STRING("hello", line);
+
+    return 0;
+}
+
+/* Checks that a line typed while the reader has yet to take the
+ * previous one is kept for the next readline.
+ */
+int test_terminal_readline_next()
+{
+    terminal_setup();
+
+    char line[16];
+    ASSERT_EQUAL_INT(TERMINAL_BLOCKED, terminal_readline(line, sizeof(line)));
+
+    terminal_type("ls\rdir\r");
+
+    ASSERT_EQUAL_INT(2, terminal_readline(line, sizeof(line)));
+    ASSERT_EQUAL_STRING("ls", line);
+
+    ASSERT_EQUAL_INT(3, terminal_readline(line, sizeof(line)));
+    ASSERT_EQUAL_STRING("dir", line);
+
+    return 0;
+}
+
+/* Checks that readline reads lines from an input pipe, waiting
+ * for the rest of a line, and reports end-of-file once the
+ * writer has gone.
+ */
+int test_terminal_readline_pipe()
+{
+    terminal_setup();
+    pipe_init();
+
+    int p = pipe_create();
+    pipe_attach(p, true);
+    process_redirect(0, p, PIPE_NONE);
+
+    char line[8];
+    ASSERT_EQUAL_INT(TERMINAL_BLOCKED, terminal_readline(line, sizeof(line)));
+
+    pipe_write(p, "ls\r\ndi", 6);
+    ASSERT_EQUAL_INT(2, terminal_readline(line, sizeof(line)));
+    ASSERT_EQUAL_STRING("ls", line);
+    ASSERT_EQUAL_INT(TERMINAL_BLOCKED, terminal_readline(line, sizeof(line)));
+
+    pipe_write(p, "r\n\nend", 6);
+    ASSERT_EQUAL_INT(3, terminal_readline(line, sizeof(line)));
+    ASSERT_EQUAL_STRING("dir", line);
+    ASSERT_EQUAL_INT(0, terminal_readline(line, sizeof(line)));
+
+    pipe_detach(p, true);
+    ASSERT_EQUAL_INT(3, terminal_readline(line, sizeof(line)));
+    ASSERT_EQUAL_STRING("end", line);
+    ASSERT_EQUAL_INT(PIPE_EOF, terminal_readline(line, sizeof(line)));
+
+    /* Nothing was read from the keyboard. */
+    ASSERT_EQUAL_INT(-1, terminal_tx_next());
+
+    return 0;
+}
+
+/* Checks that in binary mode the line is neither edited nor echoed.
+ */
+int test_terminal_readline_binary()
+{
+    terminal_setup();
+    terminal_set_mode(TERMINAL_MODE_BINARY);
+
+    char line[16];
+    ASSERT_EQUAL_INT(TERMINAL_BLOCKED, terminal_readline(line, sizeof(line)));
+
+    terminal_type("ab\bc\n");
+    ASSERT_EQUAL_INT(4, terminal_readline(line, sizeof(line)));
+    ASSERT_EQUAL_STRING("ab\bc", line);
+    ASSERT_EQUAL_INT(-1, terminal_tx_next());
+
+    return 0;
+}
+
+/* Checks that a process without the active terminal waits in
+ * readline, and is woken when it is given the terminal.
+ */
+int test_terminal_readline_inactive()
+{
+    terminal_setup();
+    terminal_add_process(1);
+    terminal_set_active(1);
+
+    char line[16];
+    ASSERT_EQUAL_INT(TERMINAL_BLOCKED, terminal_readline(line, sizeof(line)));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(0));
+
+    terminal_set_active(0);
+    ASSERT_EQUAL_INT(TASK_READY, scheduler_state(0));
+
+    return 0;
+}
+
+/* Checks that bytes received while the buffer is full are counted.
+ */
+int test_terminal_rx_dropped()
+{
+    terminal_setup();
+
+    /* The buffer holds 32 bytes. */
+    for (int i = 0; i < 35; i++) terminal_put('x');
+    ASSERT_EQUAL_INT(3, terminal_stats.dropped);
+
+    return 0;
+}
+
+/* Checks that RTS is de-asserted once the buffer passes the
+ * high-water mark, and asserted again once it has drained.
+ */
+int test_terminal_rx_rts()
+{
+    terminal_setup();
+
+    for (int i = 0; i < 23; i++) terminal_put('x');
+    ASSERT(!RTS_HIGH());
+
+    terminal_put('x');
+    ASSERT(RTS_HIGH());
+    ASSERT_EQUAL_INT(1, terminal_stats.throttled);
+
+    for (int i = 0; i < 15; i++) terminal_get();
+    ASSERT(RTS_HIGH());
+
+    terminal_get();
+    ASSERT(!RTS_HIGH());
+
+    return 0;
+}
+
+/* Checks that queued output is sent before RTS is de-asserted,
+ * as doing so disables the transmit interrupt, so that a writer
+ * blocked on a full transmit buffer is still woken.
+ */
+int test_terminal_rx_rts_writer()
+{
+    terminal_setup();
+
+    char buf[300];
+    memset(buf, 'x', sizeof(buf));
+
+    ASSERT_EQUAL_INT(255, terminal_write(buf, sizeof(buf)));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(0));
+
+    for (int i = 0; i < 24; i++) terminal_put('x');
+    ASSERT_EQUAL_INT(1, terminal_stats.throttled);
+    ASSERT(TX_ENABLED());
+
+    for (int i = 0; i < 128; i++) terminal_tx_next();
+    ASSERT_EQUAL_INT(TASK_READY, scheduler_state(0));
+
+    while (terminal_tx_next() >= 0);
+    ASSERT(RTS_HIGH());
+
+    return 0;
+}
+
+/* Checks that in binary mode with XON/XOFF selected the sender
+ * is sent XOFF and XON instead, and RTS is left alone.
+ */
+int test_terminal_rx_xonxoff()
+{
+    terminal_setup();
+    terminal_set_mode(TERMINAL_MODE_BINARY | TERMINAL_MODE_XONXOFF);
+
+    for (int i = 0; i < 24; i++) terminal_put('x');
+    ASSERT(!RTS_HIGH());
+    ASSERT_EQUAL_INT(0x13, terminal_tx_next());
+
+    for (int i = 0; i < 16; i++) terminal_get();
+    ASSERT_EQUAL_INT(0x11, terminal_tx_next());
+    ASSERT_EQUAL_INT(-1, terminal_tx_next());
+
+    return 0;
+}
+
+/* Checks that XOFF and XON are sent ahead of queued output,
+ * and that an XOFF which has not gone yet is cancelled by XON.
+ */
+int test_terminal_rx_xoff_first()
+{
+    terminal_setup();
+    terminal_set_mode(TERMINAL_MODE_BINARY | TERMINAL_MODE_XONXOFF);
+
+    terminal_write("abc", 3);
+    for (int i = 0; i < 24; i++) terminal_put('x');
+    ASSERT_EQUAL_INT(0x13, terminal_tx_next());
+    ASSERT_EQUAL_INT('a', terminal_tx_next());
+
+    for (int i = 0; i < 16; i++) terminal_get();
+    ASSERT_EQUAL_INT(0x11, terminal_tx_next());
+    ASSERT_EQUAL_INT('b', terminal_tx_next());
+
+    for (int i = 0; i < 16; i++) terminal_put('x');
+    for (int i = 0; i < 16; i++) terminal_get();
+    ASSERT_EQUAL_INT('c', terminal_tx_next());
+    ASSERT_EQUAL_INT(-1, terminal_tx_next());
+
+    return 0;
+}
+
+/* Checks that sreadn copies everything waiting in one call,
+ * up to the size of the buffer.
+ */
+int test_terminal_readn()
+{
+    terminal_setup();
+
+    char buf[8];
+    ASSERT_EQUAL_INT(0, terminal_readn(buf, sizeof(buf), 0));
+
+    terminal_type("abcdefghij");
+    ASSERT_EQUAL_INT(8, terminal_readn(buf, sizeof(buf), 0));
+    ASSERT(memcmp(buf, "abcdefgh", 8) == 0);
+
+    ASSERT_EQUAL_INT(2, terminal_readn(buf, sizeof(buf), 0));
+    ASSERT(memcmp(buf, "ij", 2) == 0);
+
+    return 0;
+}
+
+/* Checks that a reader waiting for several bytes is only
+ * woken once they have all arrived.
+ */
+int test_terminal_readn_min()
+{
+    terminal_setup();
+
+    char buf[8];
+    terminal_put('a');
+    ASSERT_EQUAL_INT(TERMINAL_BLOCKED, terminal_readn(buf, sizeof(buf), 4));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(0));
+
+    terminal_type("bc");
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(0));
+
+    terminal_put('d');
+    ASSERT_EQUAL_INT(TASK_READY, scheduler_state(0));
+    ASSERT_EQUAL_INT(4, terminal_readn(buf, sizeof(buf), 4));
+    ASSERT(memcmp(buf, "abcd", 4) == 0);
+
+    return 0;
+}
+
+/* Checks that swritev sends its pieces in order.
+ */
+int test_terminal_writev()
+{
+    terminal_setup();
+
+    IOVec_T iov[2] = {
+        { "ab", 2 },
+        { "c", 1 }
+    };
+    ASSERT_EQUAL_INT(2, terminal_writev(iov, 2));
+
+    ASSERT_EQUAL_INT('a', terminal_tx_next());
+    ASSERT_EQUAL_INT('b', terminal_tx_next());
+    ASSERT_EQUAL_INT('c', terminal_tx_next());
+    ASSERT_EQUAL_INT(-1, terminal_tx_next());
+
+    return 0;
+}
+
+/* Checks that a write which fills the transmit buffer stops in
+ * the piece that did not fit, leaving the rest of it for the retry.
+ */
+int test_terminal_writev_full()
+{
+    terminal_setup();
+
+    char buf[300];
+    memset(buf, 'x', sizeof(buf));
+
+    IOVec_T iov[2] = {
+        { "ab", 2 },
+        { buf, sizeof(buf) }
+    };
+    ASSERT_EQUAL_INT(1, terminal_writev(iov, 2));
+    ASSERT_EQUAL_INT(TASK_BLOCKED, scheduler_state(0));
+
+    ASSERT(iov[1].ptr == buf + 253);
+    ASSERT_EQUAL_INT(300 - 253, iov[1].len);
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <include/scheduler.h>
+#include <include/trace.h>
+
+#include <test.h>
+
+/* Tests that draining an empty trace returns no entries.
+ */
+int test_trace_empty()
+{
+    trace_init();
+
+    TraceEntry_T buf[4];
+    size_t n = trace_drain(buf, 4);
+    ASSERT_EQUAL_INT(0, (int)n);
+
+    return 0;
+}
+
+/* Tests that scheduler activity is recorded in order,
+ * and that draining removes entries from the trace.
+ */
+int test_trace_scheduler()
+{
+    scheduler_init();
+
+    scheduler_add(3);
+    scheduler_add(4);
+
+    scheduler_tick();
+    scheduler_tick();
+    scheduler_block(3, EVENT_PROCESS_FINISHED);
+    scheduler_exit(4, 0);
+
+    TraceEntry_T buf[8];
+    size_t n = trace_drain(buf, 8);
+    ASSERT_EQUAL_INT(4, (int)n);
+
+    ASSERT_EQUAL_INT(TRACE_SWITCH, buf[1].reason);
+    ASSERT_EQUAL_INT(3, buf[1].from);
+    ASSERT_EQUAL_INT(4, buf[1].to);
+
+    ASSERT_EQUAL_INT(TRACE_BLOCK, buf[2].reason);
+    ASSERT_EQUAL_INT(3, buf[2].from);
+    ASSERT_EQUAL_INT(EVENT_PROCESS_FINISHED, buf[2].to);
+
+    ASSERT_EQUAL_INT(TRACE_WAKE, buf[3].reason);
+    ASSERT_EQUAL_INT(3, buf[3].from);
+    ASSERT_EQUAL_INT(EVENT_PROCESS_FINISHED, buf[3].to);
+
+    n = trace_drain(buf, 8);
+    ASSERT_EQUAL_INT(0, (int)n);
+
+    return 0;
+}
+
+/* Tests that the oldest entries are overwritten when
+ * the trace is full, and that partial drains work.
+ */
+int test_trace_overflow()
+{
+    trace_init();
+
+    for (int i = 0; i < 100; i++)
+    {
+        trace_record(TRACE_SWITCH, (int8_t)i, 0);
+    }
+
+    TraceEntry_T buf[16];
+    size_t n = trace_drain(buf, 16);
+    ASSERT_EQUAL_INT(16, (int)n);
+
+    /* Trace holds the last 64 entries. */
+    ASSERT_EQUAL_INT(36, buf[0].from);
+    ASSERT_EQUAL_INT(51, buf[15].from);
+
+    n = trace_drain(buf, 16);
+    ASSERT_EQUAL_INT(16, (int)n);
+    ASSERT_EQUAL_INT(52, buf[0].from);
+
+    return 0;
+}
@@ -247,34 +247,57 @@ class Serial6850 < Zemu::Config::BusDevice
     def initialize
         super
 
+        # Bytes on their way from the host, and bytes sent to it.
         @buffer_rx = []
         @buffer_tx = []
 
+        # Receive and transmit data registers.
+        @rx_data = nil
+        @tx_data = nil
+
+        # Cycles until the byte on the line arrives or is sent.
+        @rx_timer = 0
+        @tx_timer = 0
+
+        @byte_cycles = 0
+        @overruns = 0
+
         @status = 0
         @control = 0
-        @int_rx = false
+    end
+
+    # Number of bytes lost because the receive data
+    # register was still full when the next one arrived.
+    attr_reader :overruns
+
+    # Sets the time taken to send one byte on the line, in CPU cycles.
+    # With the default of 0 bytes move as soon as there is room, and
+    # nothing is ever lost. Otherwise bytes from the host arrive one byte
+    # time apart, whether or not the last one has been read.
+    def line_delay(cycles)
+        @byte_cycles = cycles
     end
 
     def transmitted_count
         @buffer_tx.size
     end
 
+    def pending_count
+        @buffer_rx.size
+    end
+
     def get_byte()
-        @status |= 0x02
         return @buffer_tx.shift()
     end
 
     def put_byte(b)
-        @buffer_rx = [b]
-        @status |= 0x01
-        @int_rx = true
+        @buffer_rx << b
     end
 
     def io_read(port)
         if port == data_port
-            @status &= ~0x01
-            @int_rx = false
-            return @buffer_rx.shift()
+            @status &= ~0x21
+            return @rx_data
         elsif port == control_port
             return @status
         end
@@ -285,24 +308,52 @@ class Serial6850 < Zemu::Config::BusDevice
     def io_write(port, value)
         if port == data_port
             @status &= ~0x02
-            @buffer_tx = [value]
+            @tx_data = value
+            @tx_timer = @byte_cycles
         elsif port == control_port
             if ((value & 0x03) == 0x03)
                 @status = 0x02
+                @rx_data = nil
+                @tx_data = nil
             else
                 @control = value
             end
         end
     end
 
+    # RTS is high, asking the host to stop sending.
+    def rts_high?
+        (@control & 0x60) == 0x40
+    end
+
     def clock(cycles)
-        if ((@control & 0x20) == 0x20) && ((@status & 0x02) == 0x02)
-            int_tx = true
-        else
-            int_tx = false
+        # Transmit.
+        unless @tx_data.nil?
+            @tx_timer -= cycles
+            if @tx_timer <= 0
+                @buffer_tx << @tx_data
+                @tx_data = nil
+                @status |= 0x02
+            end
+        end
+
+        # Receive. The host finishes a byte it has
+        # started, but starts no more while RTS is high.
+        if @rx_timer > 0
+            @rx_timer -= cycles
+            line_receive if @rx_timer <= 0
+        elsif !@buffer_rx.empty? && !rts_high?
+            if @byte_cycles == 0
+                line_receive if (@status & 0x01) == 0
+            else
+                @rx_timer = @byte_cycles
+            end
         end
 
-        if @int_rx || int_tx
+        int_rx = (@status & 0x01) == 0x01
+        int_tx = ((@control & 0x60) == 0x20) && ((@status & 0x02) == 0x02)
+
+        if int_rx || int_tx
             @status |= 0x80
             interrupt(true)
         else
@@ -311,6 +362,20 @@ class Serial6850 < Zemu::Config::BusDevice
         end
     end
 
+    # Moves the byte on the line into the receive data register,
+    # or loses it if the last one has not been read.
+    def line_receive
+        b = @buffer_rx.shift()
+
+        if (@status & 0x01) == 0x01
+            @status |= 0x20
+            @overruns += 1
+        else
+            @rx_data = b
+            @status |= 0x01
+        end
+    end
+
     # Valid parameters for a Serial6850, along with those
     # defined in [Zemu::Config::BusDevice].
     def params
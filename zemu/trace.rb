@@ -0,0 +1,122 @@
+# Helpers for reading the kernel's scheduler trace out of a
+# running Zemu instance.
+#
+# The kernel must be built with SCHED_TRACE set, e.g.:
+#
+#   SCHED_TRACE=1 rake build:kernel_debug
+#
+# The trace buffer is located using the symbols in the kernel map file.
+
+TRACE_SIZE = 64
+TRACE_ENTRY_SIZE = 5
+TRACE_REASONS = %w(SWITCH BLOCK WAKE)
+
+# Returns the address of the given label in the map file,
+# or nil if the label is not present.
+def trace_symbol(map, label)
+    if /([0-9a-fA-F]+)\s+#{label}\s/ =~ map
+        $1.to_i(16)
+    else
+        nil
+    end
+end
+
+# Returns true if the kernel described by the given map file
+# was built with the scheduler trace enabled.
+def scheduler_trace_enabled?(map_file)
+    !trace_symbol(File.read(map_file), "_trace_buf").nil?
+end
+
+# Reads the scheduler trace from the given instance, oldest entry first.
+# Does not remove entries from the trace.
+def scheduler_trace(instance, map_file="kernel_debug.map")
+    map = File.read(map_file)
+
+    buf = trace_symbol(map, "_trace_buf")
+    return [] if buf.nil?
+
+    head = instance.memory(trace_symbol(map, "_trace_head"))
+    count = instance.memory(trace_symbol(map, "_trace_count"))
+
+    signed = lambda { |b| b >= 0x80 ? b - 0x100 : b }
+
+    entries = []
+    count.times do |i|
+        index = (head + TRACE_SIZE - count + i) % TRACE_SIZE
+        base = buf + (index * TRACE_ENTRY_SIZE)
+
+        entries << {
+            tick:   instance.memory(base) | (instance.memory(base + 1) << 8),
+            from:   signed.call(instance.memory(base + 2)),
+            to:     signed.call(instance.memory(base + 3)),
+            reason: TRACE_REASONS[instance.memory(base + 4)] || "?"
+        }
+    end
+
+    entries
+end
+
+# Renders a list of trace entries as a timeline, with one
+# column per process showing which was running after each event.
+#
+# Running processes are shown as '#', blocked processes as 'b'.
+# A summary of slices per process and the worst-case latency
+# from wake-up to running follows the timeline.
+def scheduler_timeline(entries)
+    pids = entries.flat_map do |e|
+        e[:reason] == "SWITCH" ? [e[:from], e[:to]] : [e[:from]]
+    end.uniq.select { |p| p >= 0 }.sort
+
+    running = nil
+    blocked = {}
+    woken_at = {}
+    slices = Hash.new(0)
+    latency = Hash.new(0)
+
+    lines = []
+    lines << "%-6s %-7s %-14s %s" % ["tick", "event", "detail", pids.map { |p| "%-3d" % p }.join]
+
+    entries.each do |e|
+        case e[:reason]
+        when "SWITCH"
+            detail = "#{e[:from]} -> #{e[:to]}"
+            running = e[:to]
+            slices[running] += 1
+
+            unless woken_at[running].nil?
+                wait = (e[:tick] - woken_at[running]) & 0xffff
+                latency[running] = wait if wait > latency[running]
+                woken_at.delete(running)
+            end
+        when "BLOCK"
+            detail = "#{e[:from]} on #{e[:to]}"
+            blocked[e[:from]] = true
+        when "WAKE"
+            detail = "#{e[:from]} by #{e[:to]}"
+            blocked.delete(e[:from])
+            woken_at[e[:from]] = e[:tick]
+        else
+            detail = ""
+        end
+
+        columns = pids.map do |p|
+            if blocked[p]
+                "b  "
+            elsif p == running
+                "#  "
+            else
+                ".  "
+            end
+        end
+
+        lines << "%-6d %-7s %-14s %s" % [e[:tick], e[:reason], detail, columns.join]
+    end
+
+    lines << ""
+    lines << "%-6s %-8s %s" % %w(pid slices max-latency)
+    pids.each do |p|
+        lines << "%-6d %-8d %d" % [p, slices[p], latency[p]]
+    end
+
+    lines.join("\n")
+end